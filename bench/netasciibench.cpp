@@ -0,0 +1,74 @@
+#include "netasciidecoder.h"
+#include <QElapsedTimer>
+#include <QDebug>
+#include <random>
+
+//decodes a netascii config in TFTP sized blocks with the vectorized and the
+//scalar paths of the decoder and prints their throughput
+enum { BLOCK_SIZE = 512, TOTAL_SIZE = 64 * 1024 * 1024, ROUNDS = 5 };
+
+static QByteArray makeText()
+{
+    std::mt19937 rng(1);
+    QByteArray text;
+    text.reserve(TOTAL_SIZE + 256);
+    while (TOTAL_SIZE > text.size()) {
+        //config-like lines of 10 to 80 characters
+        const int len = 10 + static_cast<int>(rng() % 71);
+        for (int i = 0; i < len; ++i) {
+            text.append(static_cast<char>('a' + rng() % 26));
+        }
+        //a few lines also carry a CR NUL or a bare CR, the blocks split some CRs
+        const unsigned int kind = rng() % 16;
+        if (0 == kind) {
+            text.append('\r');
+            text.append('\0');
+        } else if (1 == kind) {
+            text.append('\r');
+        }
+        text.append("\r\n");
+    }
+    return text;
+}
+
+template <typename Decode>
+static double run(const QByteArray &text, Decode decode, QByteArray *out)
+{
+    qint64 best = -1;
+    for (int round = 0; round < ROUNDS; ++round) {
+        NetasciiDecoder decoder;
+        out->resize(0);
+        QElapsedTimer timer;
+        timer.start();
+        for (int offset = 0; offset < text.size(); offset += BLOCK_SIZE) {
+            decode(decoder, text.constData() + offset, qMin(static_cast<int>(BLOCK_SIZE),
+                                                              text.size() - offset), out);
+        }
+        decoder.finish(out);
+        const qint64 elapsed = timer.nsecsElapsed();
+        best = ((0 > best) || (elapsed < best)) ? elapsed : best;
+    }
+    return (text.size() / (1024.0 * 1024.0)) / (best / 1e9);
+}
+
+int main()
+{
+    const QByteArray text = makeText();
+    QByteArray vectorized;
+    QByteArray scalar;
+    vectorized.reserve(text.size() + 1);
+    scalar.reserve(text.size() + 1);
+    const double fast = run(text, [](NetasciiDecoder &decoder, const char *data, int size, QByteArray *out) {
+        decoder.decode(data, size, out);
+    }, &vectorized);
+    const double slow = run(text, [](NetasciiDecoder &decoder, const char *data, int size, QByteArray *out) {
+        decoder.decodeScalar(data, size, out);
+    }, &scalar);
+    if (vectorized != scalar) {
+        qCritical() << "Outputs differ";
+        return 1;
+    }
+    qInfo().noquote() << NetasciiDecoder::instructionSet() << ":" << fast << "MB/s, scalar :"
+                      << slow << "MB/s," << (fast / slow) << "x";
+    return 0;
+}
@@ -4,13 +4,19 @@ import QtQuick.Controls 2.12
 Dialog {
     id: control
     implicitWidth: 400
-    implicitHeight: 260
+    implicitHeight: 500
     x: (mainWin.width-width)/2
     y: (mainWin.height-height)/2
     z: 2
     onAccepted: {
         client.serverPort = tftpPort.text
         client.readDelayMs = timeout.text
+        client.tracing = tracing.checked
+        client.adaptiveConcurrency = adaptiveConcurrency.checked
+        client.negativeCacheTtl = negativeCacheTtl.text
+        client.incremental = incremental.checked
+        client.changeReport = changeReport.checked
+        client.netascii = netascii.checked
         if (client.numWorkers !== numWorkers.value) {
             client.numWorkers = numWorkers.value
             msgDlgProps.fatalError = true
@@ -23,7 +29,7 @@ Dialog {
     closePolicy: Popup.CloseOnEscape
     standardButtons: Dialog.Ok | Dialog.Cancel
     Grid {
-        rows: 3
+        rows: 9
         columns: 2
         rowSpacing: 5
         columnSpacing: 10
@@ -59,6 +65,22 @@ Dialog {
             font.pointSize: appStyle.textFontSize
             selectByMouse: true
         }
+        Label {
+            text: qsTr("Skip failed hosts for [seconds]")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: negativeCacheTtl.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        TextField {
+            id: negativeCacheTtl
+            text: client.negativeCacheTtl
+            validator: IntValidator { bottom: 0 }
+            width: appStyle.textFieldWidth
+            font.pointSize: appStyle.textFontSize
+            selectByMouse: true
+        }
         Label {
             text: qsTr("Number of workers")
             elide: Text.ElideRight
@@ -83,5 +105,71 @@ Dialog {
             width: appStyle.textFieldWidth
             font.pointSize: appStyle.textFontSize
         }
+        Label {
+            text: qsTr("Adapt workers to the network")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: adaptiveConcurrency.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        CheckBox {
+            id: adaptiveConcurrency
+            checked: client.adaptiveConcurrency
+            font.pointSize: appStyle.textFontSize
+        }
+        Label {
+            text: qsTr("Record timeline")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: tracing.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        CheckBox {
+            id: tracing
+            checked: client.tracing
+            font.pointSize: appStyle.textFontSize
+        }
+        Label {
+            text: qsTr("Write only changed files")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: incremental.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        CheckBox {
+            id: incremental
+            checked: client.incremental
+            font.pointSize: appStyle.textFontSize
+        }
+        Label {
+            text: qsTr("Report changed files")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: changeReport.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        CheckBox {
+            id: changeReport
+            checked: client.changeReport
+            enabled: incremental.checked
+            font.pointSize: appStyle.textFontSize
+        }
+        Label {
+            text: qsTr("Text mode (netascii)")
+            elide: Text.ElideRight
+            clip: true
+            font.pointSize: appStyle.textFontSize
+            height: netascii.height
+            verticalAlignment: Text.AlignVCenter
+        }
+        CheckBox {
+            id: netascii
+            checked: client.netascii
+            font.pointSize: appStyle.textFontSize
+        }
     }
 }
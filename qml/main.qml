@@ -97,7 +97,8 @@ ApplicationWindow {
         }
         visible: progressBar.visible
         font.pointSize: appStyle.textFontSize - 2
-        text: qsTr("Address index ") + client.addrIndex
+        text: qsTr("Address index ") + client.addrIndex +
+              ((0 < client.concurrency) ? qsTr(", concurrency limit ") + client.concurrency : "")
         horizontalAlignment: Text.AlignHCenter
     }
     Label {
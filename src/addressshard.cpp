@@ -0,0 +1,35 @@
+#include "addressshard.h"
+
+quint64 AddressShard::apply(int index, int count, QVector<QString> *singleAddresses,
+                            QVector<QPair<quint32, quint32> > *pairAddresses)
+{
+    quint64 total = static_cast<quint64>(singleAddresses->size());
+    for (const auto &pairIp: *pairAddresses) {
+        total += static_cast<quint64>(pairIp.second - pairIp.first) + 1;
+    }
+    const quint64 first = total * index / count;
+    const quint64 last = total * (index + 1) / count;
+    quint64 pos = 0;
+    QVector<QString> singles;
+    for (const auto &ip: *singleAddresses) {
+        if ((first <= pos) && (last > pos)) {
+            singles.append(ip);
+        }
+        ++pos;
+    }
+    QVector<QPair<quint32, quint32> > pairs;
+    for (const auto &pairIp: *pairAddresses) {
+        const quint64 size = static_cast<quint64>(pairIp.second - pairIp.first) + 1;
+        const quint64 begin = qMax(pos, first);
+        const quint64 end = qMin(pos + size, last);
+        if (begin < end) {
+            pairs.append(QPair<quint32, quint32>(
+                             static_cast<quint32>(pairIp.first + (begin - pos)),
+                             static_cast<quint32>(pairIp.first + (end - pos - 1))));
+        }
+        pos += size;
+    }
+    singleAddresses->swap(singles);
+    pairAddresses->swap(pairs);
+    return last - first;
+}
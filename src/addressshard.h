@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+//contiguous slice of the address list swept by one of several processes
+class AddressShard
+{
+public:
+    //keeps the addresses of slice index (zero based) out of count, in list
+    //order: the single addresses first, then the ranges; returns how many
+    static quint64 apply(int index, int count, QVector<QString> *singleAddresses,
+                         QVector<QPair<quint32, quint32> > *pairAddresses);
+};
@@ -0,0 +1,81 @@
+#include "aimdcontroller.h"
+
+void AimdController::reset(int window, int maxWindow, qint64 now)
+{
+    _maxWindow = qMax(1, maxWindow);
+    _window = qBound(1, window, _maxWindow);
+    _nextUpdate = now + INTERVAL_MS;
+    _holding = false;
+    _finished = _timeouts = _stalls = _blocks = _duplicates = 0;
+    _lastFinished = 0;
+    _timeoutBaseline = -1;
+    _excess = 0;
+    _hasRtt = false;
+    _minRtt.clear();
+}
+
+void AimdController::onRtt(quint32 address, qint64 ms)
+{
+    auto it = _minRtt.find(address);
+    if (_minRtt.end() == it) {
+        it = _minRtt.insert(address, ms);
+    } else if (ms < it.value()) {
+        it.value() = ms;
+    }
+    const double excess = static_cast<double>(ms - (2 * it.value() + 5));
+    _excess = _hasRtt ? (0.875 * _excess + 0.125 * excess) : excess;
+    _hasRtt = true;
+}
+
+void AimdController::onFinished(bool timedOut, bool stalled)
+{
+    ++_finished;
+    if (stalled) {
+        ++_stalls;
+    } else if (timedOut) {
+        ++_timeouts;
+    }
+}
+
+bool AimdController::update(qint64 now)
+{
+    if (now < _nextUpdate) {
+        return false;
+    }
+    _nextUpdate = now + INTERVAL_MS;
+
+    const int previous = _window;
+    if (congested()) {
+        _window = qMax(1, _window / 2);
+        _holding = true;
+    } else if (_holding) {
+        //let the throughput settle after a decrease
+        _holding = false;
+    } else if ((_finished >= _lastFinished) && (_window < _maxWindow)) {
+        ++_window;
+    }
+
+    if (MIN_SAMPLES <= _finished) {
+        const double ratio = static_cast<double>(_timeouts) / _finished;
+        _timeoutBaseline = (0 > _timeoutBaseline) ? ratio :
+                                                    (0.75 * _timeoutBaseline + 0.25 * ratio);
+    }
+    _lastFinished = _finished;
+    _finished = _timeouts = _stalls = _blocks = _duplicates = 0;
+    return previous != _window;
+}
+
+bool AimdController::congested() const
+{
+    //lost ACKs or DATA blocks
+    if ((0 < _stalls) || ((0 < _blocks) && (0.02 < static_cast<double>(_duplicates) / _blocks))) {
+        return true;
+    }
+    //probes that used to be answered now time out
+    if ((MIN_SAMPLES <= _finished) && (0 <= _timeoutBaseline) &&
+            ((_timeoutBaseline + 0.1) < static_cast<double>(_timeouts) / _finished)) {
+        return true;
+    }
+    //queues build up along the paths
+    return _hasRtt && (0 < _excess);
+}
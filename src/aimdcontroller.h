@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QHash>
+
+//additive increase, multiplicative decrease of the number of transfers in
+//flight: grows by one per interval while throughput grows and the network
+//looks healthy, halves on stalls, duplicate blocks, timeout spikes or
+//queueing delay
+class AimdController
+{
+public:
+    enum { INTERVAL_MS = 1000, MIN_SAMPLES = 8 };
+    void reset(int window, int maxWindow, qint64 now);
+    int window() const { return _window; }
+    //hosts have their own base RTT, only the delay added on top of it counts
+    void onRtt(quint32 address, qint64 ms);
+    void onBlock() { ++_blocks; }
+    void onDuplicate() { ++_duplicates; }
+    //a transfer ended, stalled means it timed out after some data was received
+    void onFinished(bool timedOut, bool stalled);
+    //returns true when the window changed
+    bool update(qint64 now);
+private:
+    bool congested() const;
+
+    int _window = 1;
+    int _maxWindow = 1;
+    qint64 _nextUpdate = 0;
+    bool _holding = false;
+    //counters of the current interval
+    int _finished = 0;
+    int _timeouts = 0;
+    int _stalls = 0;
+    int _blocks = 0;
+    int _duplicates = 0;
+    int _lastFinished = 0;
+    //most probes of dead hosts time out, only a rise above this is a signal
+    double _timeoutBaseline = -1;
+    //smoothed RTT in excess of twice the base RTT of the host, plus 5 ms
+    double _excess = 0;
+    bool _hasRtt = false;
+    QHash<quint32, qint64> _minRtt;
+};
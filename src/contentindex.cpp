@@ -0,0 +1,121 @@
+#include "contentindex.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QHostAddress>
+#include <QObject>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+bool ContentIndex::load(const QString &fileName)
+{
+    QMutexLocker locker(&_mutex);
+    _hashes.clear();
+    _changes.clear();
+    if (!_enabled) {
+        return true;
+    }
+
+    QFile ifile(fileName);
+    if (!ifile.exists()) {
+        return true;
+    }
+    if (!ifile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot open" << fileName;
+        return false;
+    }
+    QDataStream in(&ifile);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if ((MAGIC != magic) || (VERSION != version)) {
+        qWarning() << "Ignoring content index with unknown format" << fileName;
+        return true;
+    }
+    in >> _hashes;
+    if (QDataStream::Ok != in.status()) {
+        qWarning() << "Ignoring corrupted content index" << fileName;
+        _hashes.clear();
+        return true;
+    }
+    qInfo() << "Content index:" << _hashes.size() << "files";
+    return true;
+}
+
+bool ContentIndex::save(const QString &fileName)
+{
+    QMutexLocker locker(&_mutex);
+    if (!_enabled) {
+        return true;
+    }
+    //files of hosts that did not answer this time keep their previous hash
+    QSaveFile ofile(fileName);
+    if (!ofile.open(QIODevice::WriteOnly)) {
+        qCritical() << "Cannot open file for writing" << fileName;
+        return false;
+    }
+    QDataStream out(&ofile);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint32>(MAGIC) << static_cast<quint32>(VERSION) << _hashes;
+    return ofile.commit();
+}
+
+ContentIndex::Change ContentIndex::compare(quint32 address, const QString &filename,
+                                           const QByteArray &content, QByteArray *hash) const
+{
+    //hashing is done by the calling worker, outside the lock
+    *hash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+    QMutexLocker locker(&_mutex);
+    auto it = _hashes.constFind(Key(address, filename));
+    if (_hashes.constEnd() == it) {
+        return Added;
+    }
+    return (it.value() == *hash) ? Unchanged : Modified;
+}
+
+void ContentIndex::commit(quint32 address, const QString &filename, const QByteArray &hash,
+                          Change change)
+{
+    QMutexLocker locker(&_mutex);
+    _hashes.insert(Key(address, filename), hash);
+    if (Unchanged != change) {
+        const ChangedFile changed = {address, filename, change};
+        _changes.append(changed);
+    }
+}
+
+bool ContentIndex::writeReport(const QString &fileName, const QString &workingFolder,
+                               QString *error) const
+{
+    QVector<ChangedFile> changes;
+    {
+        QMutexLocker locker(&_mutex);
+        changes = _changes;
+    }
+    //the workers finish in any order
+    std::stable_sort(changes.begin(), changes.end(), [](const ChangedFile &a, const ChangedFile &b) {
+        return a.address < b.address;
+    });
+
+    QFile ofile(fileName);
+    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        *error = QObject::tr("Cannot open file for writing ") + fileName;
+        return false;
+    }
+    QTextStream stream(&ofile);
+    for (const auto &changed: changes) {
+        const QString address = QHostAddress(changed.address).toString();
+        stream << address << ": " << workingFolder << "/" << address << "/" << changed.filename
+               << ((Added == changed.change) ? " added" : " modified") << endl;
+    }
+    return true;
+}
+
+int ContentIndex::changeCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _changes.size();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+//hash of every file downloaded by the previous sweeps, kept on disk so that
+//an incremental sweep writes only the files whose content changed
+class ContentIndex
+{
+public:
+    enum Change { Added, Modified, Unchanged };
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool enabled() const { return _enabled; }
+    //a missing file gives an empty index
+    bool load(const QString &fileName);
+    bool save(const QString &fileName);
+    //thread safe, compares the content with the previous sweeps
+    Change compare(quint32 address, const QString &filename, const QByteArray &content,
+                   QByteArray *hash) const;
+    //records the hash given by compare() once the content is safely on disk
+    void commit(quint32 address, const QString &filename, const QByteArray &hash,
+                Change change);
+    //address: path added|modified lines of the files that changed, sorted by address
+    bool writeReport(const QString &fileName, const QString &workingFolder, QString *error) const;
+    int changeCount() const;
+private:
+    enum { MAGIC = 0x43494458, VERSION = 1 };
+    typedef QPair<quint32, QString> Key;
+    struct ChangedFile {
+        quint32 address;
+        QString filename;
+        Change change;
+    };
+
+    mutable QMutex _mutex;
+    bool _enabled = false;
+    //SHA-1 of the content
+    QHash<Key, QByteArray> _hashes;
+    QVector<ChangedFile> _changes;
+};
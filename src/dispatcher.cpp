@@ -0,0 +1,514 @@
+#include "dispatcher.h"
+#include "udptransport.h"
+#include "mmsgtransport.h"
+#include "tracer.h"
+#include <QDebug>
+#include <limits>
+
+Dispatcher::Dispatcher(int numSockets) : _numSockets(qMax(1, numSockets)),
+#ifdef USE_MMSG_TRANSPORT
+    _transport(new MmsgTransport())
+#else
+    _transport(new UdpTransport())
+#endif
+{
+    _running = false;
+    _active = false;
+    _cancelled = false;
+    _window = std::numeric_limits<int>::max();
+}
+
+Dispatcher::~Dispatcher()
+{
+    stop();
+}
+
+void Dispatcher::setTransport(Transport *transport)
+{
+    _transport.reset(transport);
+}
+
+void Dispatcher::setConcurrency(int window, int maxWindow, bool adaptive)
+{
+    _initialWindow = window;
+    _maxWindow = maxWindow;
+    _adaptive = adaptive;
+}
+
+void Dispatcher::setConcurrencyCallback(const std::function<void(int)> &callback)
+{
+    _concurrencyChanged = callback;
+}
+
+bool Dispatcher::start(quint16 serverPort, int readDelayMs)
+{
+    stop();
+    _cancelled = false;
+    _running = true;
+
+    std::promise<bool> started;
+    std::future<bool> startedFuture = started.get_future();
+    _thread = std::thread(&Dispatcher::run, this, serverPort, readDelayMs, &started);
+    const bool rc = startedFuture.get();
+    if (!rc) {
+        stop();
+    }
+    return rc;
+}
+
+void Dispatcher::stop()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void Dispatcher::cancel()
+{
+    _cancelled = true;
+}
+
+Dispatcher::Result Dispatcher::get(const QString &serverAddress,
+                                   const QByteArray &reqPacket)
+{
+    return submit(serverAddress, reqPacket).get();
+}
+
+std::future<Dispatcher::Result> Dispatcher::submit(const QString &serverAddress,
+                                                   const QByteArray &reqPacket)
+{
+    Transfer *t = new Transfer();
+    std::future<Result> future = t->promise.get_future();
+
+    bool isIPv4 = false;
+    const QHostAddress hostAddress(serverAddress);
+    const quint32 address = hostAddress.toIPv4Address(&isIPv4);
+    if (!isIPv4) {
+        finish(t, Error, QString("Invalid server address %1").arg(serverAddress));
+        return future;
+    }
+    t->key = TransferKey{address, 0, 0};
+    t->hostAddress = hostAddress;
+    t->reqPacket = reqPacket;
+
+    QMutexLocker locker(&_submitMutex);
+    if (!_active || _cancelled) {
+        locker.unlock();
+        finish(t, Cancelled);
+        return future;
+    }
+    if (_unreachableHosts.contains(address)) {
+        locker.unlock();
+        finish(t, Unreachable);
+        return future;
+    }
+    _submitted.enqueue(t);
+    return future;
+}
+
+void Dispatcher::run(quint16 serverPort, int readDelayMs, std::promise<bool> *started)
+{
+    const bool rc = open(serverPort, readDelayMs);
+    started->set_value(rc);
+    while (rc && _running) {
+        step();
+    }
+    close();
+}
+
+bool Dispatcher::open(quint16 serverPort, int readDelayMs)
+{
+    _serverPort = serverPort;
+    _readDelayMs = readDelayMs;
+    if (!_transport->open(_numSockets)) {
+        return false;
+    }
+    _localPorts.clear();
+    _load.clear();
+    _closedTids.clear();
+    _closedOrder.clear();
+    for (int s = 0; s < _transport->socketCount(); ++s) {
+        _localPorts.append(_transport->localPort(s));
+        _load.append(0);
+    }
+    if (_adaptive) {
+        _aimd.reset(_initialWindow, _maxWindow, _transport->now());
+        _window = _aimd.window();
+    } else {
+        //the number of workers is the only limit
+        _window = std::numeric_limits<int>::max();
+    }
+    QMutexLocker locker(&_submitMutex);
+    _unreachableHosts.clear();
+    _active = true;
+    return true;
+}
+
+void Dispatcher::step()
+{
+    if (_cancelled) {
+        failAll(Cancelled, QString());
+    }
+    acceptSubmitted();
+    bool received = false;
+    Transport::Datagram datagram;
+    for (int s = 0; s < _localPorts.size(); ++s) {
+        while (_transport->receive(s, &datagram)) {
+            handleDatagram(s, datagram);
+            received = true;
+        }
+    }
+    expireTransfers();
+    if (_adaptive && _aimd.update(_transport->now())) {
+        _window = _aimd.window();
+        Tracer::instance().counter("concurrency", _window);
+        if (_concurrencyChanged) {
+            _concurrencyChanged(_window);
+        }
+    }
+    //the requests and ACKs of this step leave together
+    _transport->flush();
+    if (!received) {
+        _transport->wait(POLL_INTERVAL_MS);
+    }
+}
+
+void Dispatcher::close()
+{
+    {
+        //no submission can slip in after the last ones have been drained
+        QMutexLocker locker(&_submitMutex);
+        _active = false;
+        _unreachableHosts.clear();
+    }
+    failAll(Cancelled, QString());
+    _transport->close();
+    _localPorts.clear();
+    _load.clear();
+    _closedTids.clear();
+    _closedOrder.clear();
+}
+
+void Dispatcher::acceptSubmitted()
+{
+    {
+        QMutexLocker locker(&_submitMutex);
+        while (!_submitted.isEmpty()) {
+            _waiting.enqueue(_submitted.dequeue());
+        }
+    }
+    //transfers that cannot be placed yet keep their order
+    for (int n = _waiting.size(); (0 < n) && (_transfers.size() < _window); --n) {
+        Transfer *t = _waiting.dequeue();
+        if (!assignSocket(t)) {
+            _waiting.enqueue(t);
+        }
+    }
+}
+
+bool Dispatcher::assignSocket(Transfer *t)
+{
+    //the first DATA of a transfer can be matched to its request only if no
+    //other transfer to the same host is pending on the same local port, nor
+    //bound to a server that replies from its listen port
+    int best = -1;
+    int fenced = 0;
+    for (int s = 0; s < _localPorts.size(); ++s) {
+        if (_closedTids.contains(TransferKey{t->key.address, 0, _localPorts.at(s)})) {
+            //the reply to a request that timed out may still come on this port
+            ++fenced;
+            continue;
+        }
+        if (_transfers.contains(TransferKey{t->key.address, 0, _localPorts.at(s)}) ||
+                _transfers.contains(TransferKey{t->key.address, _serverPort, _localPorts.at(s)})) {
+            continue;
+        }
+        if ((-1 == best) || (_load.at(s) < _load.at(best))) {
+            best = s;
+        }
+    }
+    if (_localPorts.size() == fenced) {
+        //the host left every request on every port unanswered
+        finish(t, Timeout, QString("No reply to the previous requests"));
+        return true;
+    }
+    if (-1 == best) {
+        return false;
+    }
+
+    t->socketIndex = best;
+    t->key.localPort = _localPorts.at(best);
+    ++_load[best];
+    _transfers.insert(t->key, t);
+
+    if (!_transport->send(best, t->reqPacket, t->hostAddress, _serverPort)) {
+        finish(t, SendFailed, QString("Cannot send packet to host : %1").arg(_transport->errorString(best)));
+        return true;
+    }
+    t->lastSent = _transport->now();
+    t->deadline = t->lastSent + _readDelayMs;
+    Tracer::instance().instant("rrq sent", t->key.address);
+    return true;
+}
+
+void Dispatcher::handleDatagram(int s, const Transport::Datagram &datagram)
+{
+    const quint16 senderPort = datagram.senderPort;
+    bool isIPv4 = false;
+    const quint32 address = datagram.sender.toIPv4Address(&isIPv4);
+    if (!isIPv4) {
+        return;
+    }
+    const quint16 localPort = _localPorts.at(s);
+
+    if (datagram.unreachable) {
+        //fail fast instead of waiting for the timeout
+        auto it = _transfers.find(TransferKey{address, senderPort, localPort});
+        if (_transfers.end() != it) {
+            //an ACK bounced off a TID the server already closed, the host is up
+            finish(it.value(), Error, QString("Server closed the transfer"));
+            return;
+        }
+        if (_serverPort != senderPort) {
+            return;
+        }
+        //only a bounced request tells that nothing listens on the host
+        it = _transfers.find(TransferKey{address, 0, localPort});
+        if (_transfers.end() != it) {
+            Tracer::instance().instant("unreachable", address);
+            finish(it.value(), Unreachable);
+            failHost(address);
+        }
+        return;
+    }
+
+    const QByteArray &data = datagram.data;
+    const char *buffer = data.constData();
+    const bool isError = (4 <= data.size()) && (0x00 == buffer[0]) && (0x05 == buffer[1]);
+    const bool isFirstData = (4 <= data.size()) && (0x00 == buffer[0]) && (0x03 == buffer[1]) &&
+            (0x00 == buffer[2]) && (0x01 == buffer[3]);
+
+    const TransferKey key{address, senderPort, localPort};
+    auto it = _transfers.find(key);
+    if (_transfers.end() == it) {
+        if (_closedTids.contains(key)) {
+            //late or retransmitted datagram of a transfer that is over
+            return;
+        }
+        //only the first DATA or an ERROR of a transfer binds the server TID
+        if (isFirstData || isError) {
+            it = _transfers.find(TransferKey{address, 0, localPort});
+        }
+        if (_transfers.end() == it) {
+            const TransferKey fence{address, 0, localPort};
+            if ((isFirstData || isError) && (_serverPort != senderPort) && _closedTids.contains(fence)) {
+                //the late reply to a request that timed out, the port can be
+                //used again once the retransmissions of this TID are ignored
+                _closedTids.remove(fence);
+                closeTid(key);
+            }
+            //an ERROR is never answered with an ERROR
+            if (!isError) {
+                sendError(s, datagram.sender, senderPort, 5, "Unknown transfer ID");
+            }
+            return;
+        }
+        Transfer *t = it.value();
+        _transfers.erase(it);
+        t->key.remoteTid = senderPort;
+        it = _transfers.insert(t->key, t);
+        Tracer::instance().instant("first data", address);
+    }
+    Transfer *t = it.value();
+
+    if (4 > data.size()) {
+        finish(t, Error, QString("Incoming packet is too short (%1).").arg(data.size()));
+        return;
+    }
+    if (0x00 != buffer[0]) {
+        finish(t, Error, QString("Incoming packet has invalid first byte (%1).").arg(static_cast<int>(buffer[0])));
+        return;
+    }
+    const char opCode = buffer[1];
+    const quint16 block = static_cast<quint16>((static_cast<uchar>(buffer[2]) << 8) |
+            static_cast<uchar>(buffer[3]));
+    if (0x05 == opCode) {
+        t->errorCode = block;
+        finish(t, Error, QString("Server error %1: %2").arg(block).arg(QString::fromLatin1(buffer + 4)));
+        return;
+    }
+    if (0x03 != opCode) {
+        finish(t, Error, QString("Incoming packet returned invalid operation code (%1).").arg(static_cast<int>(opCode)));
+        return;
+    }
+
+    if (block == t->expectedBlock) {
+        if (_adaptive) {
+            _aimd.onRtt(t->key.address, _transport->now() - t->lastSent);
+            _aimd.onBlock();
+        }
+        const int payloadSize = data.size() - 4;
+        if (_netascii) {
+            t->decoder.decode(buffer + 4, payloadSize, &t->content);
+        } else {
+            t->content.append(buffer + 4, payloadSize);
+        }
+        if (!sendAck(t, block)) {
+            return;
+        }
+        ++t->expectedBlock;
+        if (MAX_PACKET_SIZE > payloadSize) {
+            t->decoder.finish(&t->content);
+            finish(t, Success);
+        } else {
+            t->deadline = _transport->now() + _readDelayMs;
+        }
+    } else if (block == static_cast<quint16>(t->expectedBlock - 1)) {
+        //our previous ACK was lost, acknowledge the duplicate again
+        if (_adaptive) {
+            _aimd.onDuplicate();
+        }
+        sendAck(t, block);
+    } else {
+        finish(t, Error, QString("Error on incoming packet number %1 vs expected %2").arg(block).arg(t->expectedBlock));
+    }
+}
+
+void Dispatcher::expireTransfers()
+{
+    const qint64 now = _transport->now();
+    while (!_closedOrder.isEmpty() && (now >= _closedOrder.head().first)) {
+        const QPair<qint64, TransferKey> closed = _closedOrder.dequeue();
+        //the same TID may have been closed again since
+        if (_closedTids.value(closed.second, -1) == closed.first) {
+            _closedTids.remove(closed.second);
+        }
+    }
+    QVector<Transfer*> expired;
+    for (Transfer *t: _transfers) {
+        if (now >= t->deadline) {
+            expired.append(t);
+        }
+    }
+    for (Transfer *t: expired) {
+        Tracer::instance().instant("timeout", t->key.address);
+        finish(t, Timeout);
+    }
+}
+
+void Dispatcher::closeTid(const TransferKey &key)
+{
+    const qint64 expiry = _transport->now() + CLOSED_TID_MS;
+    _closedTids.insert(key, expiry);
+    _closedOrder.enqueue(qMakePair(expiry, key));
+}
+
+void Dispatcher::finish(Transfer *t, Status status, const QString &error)
+{
+    if (0 <= t->socketIndex) {
+        --_load[t->socketIndex];
+        _transfers.remove(t->key);
+        //a server that replies from its listen port uses it for every
+        //transfer, the next DATA 1 from there belongs to the next request
+        if ((0 != t->key.remoteTid) && (_serverPort != t->key.remoteTid)) {
+            closeTid(t->key);
+        } else if ((0 == t->key.remoteTid) && (Timeout == status)) {
+            //no new request to the host on this port until the reply comes
+            //or the server gives up, it would be taken for the new one
+            closeTid(t->key);
+        }
+        if (_adaptive && (Cancelled != status)) {
+            _aimd.onFinished(Timeout == status, (Timeout == status) && (0 != t->key.remoteTid));
+        }
+    }
+    Result result;
+    result.status = status;
+    result.errorCode = t->errorCode;
+    result.error = error;
+    if (Success == status) {
+        result.content = t->content;
+    }
+    //the request packet is released before the waiting worker wakes up and
+    //renders its next request into the same buffer
+    std::promise<Result> promise(std::move(t->promise));
+    delete t;
+    promise.set_value(result);
+}
+
+void Dispatcher::failAll(Status status, const QString &error)
+{
+    {
+        QMutexLocker locker(&_submitMutex);
+        while (!_submitted.isEmpty()) {
+            _waiting.enqueue(_submitted.dequeue());
+        }
+    }
+    while (!_waiting.isEmpty()) {
+        finish(_waiting.dequeue(), status, error);
+    }
+    const auto transfers = _transfers.values();
+    for (Transfer *t: transfers) {
+        finish(t, status, error);
+    }
+}
+
+void Dispatcher::failHost(quint32 address)
+{
+    {
+        QMutexLocker locker(&_submitMutex);
+        _unreachableHosts.insert(address);
+        while (!_submitted.isEmpty()) {
+            _waiting.enqueue(_submitted.dequeue());
+        }
+    }
+    //the other requests to the host would only bounce too, transfers that
+    //already receive data are left alone
+    for (int n = _waiting.size(); 0 < n; --n) {
+        Transfer *t = _waiting.dequeue();
+        if (address == t->key.address) {
+            finish(t, Unreachable);
+        } else {
+            _waiting.enqueue(t);
+        }
+    }
+    QVector<Transfer*> unbound;
+    for (Transfer *t: _transfers) {
+        if ((address == t->key.address) && (0 == t->key.remoteTid)) {
+            unbound.append(t);
+        }
+    }
+    for (Transfer *t: unbound) {
+        finish(t, Unreachable);
+    }
+}
+
+bool Dispatcher::sendAck(Transfer *t, quint16 block)
+{
+    QByteArray ackByteArray;
+    ackByteArray.append(static_cast<char>(0x00));
+    ackByteArray.append(static_cast<char>(0x04));
+    ackByteArray.append(static_cast<char>(block >> 8));
+    ackByteArray.append(static_cast<char>(block & 0xff));
+
+    //acknowledge to the server TID, not to the well known port
+    if (!_transport->send(t->socketIndex, ackByteArray, t->hostAddress, t->key.remoteTid)) {
+        finish(t, SendFailed, QString("Cannot send ack packet to host : %1").arg(_transport->errorString(t->socketIndex)));
+        return false;
+    }
+    t->lastSent = _transport->now();
+    return true;
+}
+
+void Dispatcher::sendError(int s, const QHostAddress &host, quint16 port,
+                           quint16 code, const QString &msg)
+{
+    QByteArray errByteArray;
+    errByteArray.append(static_cast<char>(0x00));
+    errByteArray.append(static_cast<char>(0x05));
+    errByteArray.append(static_cast<char>(code >> 8));
+    errByteArray.append(static_cast<char>(code & 0xff));
+    errByteArray.append(msg.toLatin1());
+    errByteArray.append(static_cast<char>(0x00));
+    _transport->send(s, errByteArray, host, port);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "transport.h"
+#include "aimdcontroller.h"
+#include "netasciidecoder.h"
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QSet>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <thread>
+
+//identifies a transfer as defined by RFC 1350: the remote TID is the port
+//chosen by the server for this transfer and is zero until its first DATA
+struct TransferKey {
+    quint32 address;
+    quint16 remoteTid;
+    quint16 localPort;
+};
+
+inline bool operator==(const TransferKey &a, const TransferKey &b)
+{
+    return (a.address == b.address) && (a.remoteTid == b.remoteTid) &&
+            (a.localPort == b.localPort);
+}
+
+inline uint qHash(const TransferKey &key, uint seed = 0)
+{
+    return qHash((static_cast<quint64>(key.address) << 32) |
+                 (static_cast<quint64>(key.remoteTid) << 16) | key.localPort, seed);
+}
+
+//demultiplexes many concurrent read requests over a small set of local sockets
+class Dispatcher
+{
+public:
+    enum { DEFAULT_NUM_SOCKETS = 4, MAX_PACKET_SIZE = 512, POLL_INTERVAL_MS = 5,
+           //long enough to outlast the retransmissions of most servers
+           CLOSED_TID_MS = 30000 };
+    //SendFailed: the local socket refused the request or an ACK
+    enum Status { Success, Timeout, Unreachable, Error, Cancelled, SendFailed };
+    struct Result {
+        Status status = Error;
+        //error code sent by the server, -1 if none
+        int errorCode = -1;
+        QByteArray content;
+        QString error;
+    };
+    explicit Dispatcher(int numSockets = DEFAULT_NUM_SOCKETS);
+    ~Dispatcher();
+    //takes ownership, must be called while the dispatcher is stopped
+    void setTransport(Transport *transport);
+    //a host has at most one unanswered request per local socket, so as
+    //many sockets as workers are needed, must be called while stopped
+    void setSocketCount(int numSockets) { _numSockets = qMax(1, numSockets); }
+    //limits the transfers in flight, adjusted between 1 and maxWindow when
+    //adaptive, must be called while the dispatcher is stopped
+    void setConcurrency(int window, int maxWindow, bool adaptive);
+    //called from the dispatcher thread when the adaptive limit changes
+    void setConcurrencyCallback(const std::function<void(int)> &callback);
+    int concurrency() const { return _window; }
+    //netascii content is translated to local text as the blocks arrive,
+    //must be called while the dispatcher is stopped
+    void setNetascii(bool netascii) { _netascii = netascii; }
+    //runs the dispatcher in its own thread
+    bool start(quint16 serverPort, int readDelayMs);
+    void stop();
+    void cancel();
+    //blocks the calling thread until the transfer completes or fails
+    Result get(const QString &serverAddress, const QByteArray &reqPacket);
+    std::future<Result> submit(const QString &serverAddress, const QByteArray &reqPacket);
+    //single threaded use, e.g. over a simulated transport: open, then call
+    //step() until the submitted transfers are ready, then close
+    bool open(quint16 serverPort, int readDelayMs);
+    void step();
+    void close();
+private:
+    struct Transfer {
+        TransferKey key;
+        QHostAddress hostAddress;
+        int socketIndex = -1;
+        QByteArray reqPacket;
+        quint16 expectedBlock = 1;
+        QByteArray content;
+        NetasciiDecoder decoder;
+        qint64 deadline = 0;
+        qint64 lastSent = 0;
+        int errorCode = -1;
+        std::promise<Result> promise;
+    };
+    void run(quint16 serverPort, int readDelayMs, std::promise<bool> *started);
+    void acceptSubmitted();
+    bool assignSocket(Transfer *t);
+    void handleDatagram(int s, const Transport::Datagram &datagram);
+    void expireTransfers();
+    void closeTid(const TransferKey &key);
+    void finish(Transfer *t, Status status, const QString &error = QString());
+    void failAll(Status status, const QString &error);
+    void failHost(quint32 address);
+    bool sendAck(Transfer *t, quint16 block);
+    void sendError(int s, const QHostAddress &host, quint16 port,
+                   quint16 code, const QString &msg);
+
+    int _numSockets;
+    QScopedPointer<Transport> _transport;
+    quint16 _serverPort = 0;
+    int _readDelayMs = 0;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<bool> _active;
+    std::atomic<bool> _cancelled;
+    std::atomic<int> _window;
+    int _initialWindow = 1;
+    int _maxWindow = 1;
+    bool _adaptive = false;
+    bool _netascii = false;
+    std::function<void(int)> _concurrencyChanged;
+    QMutex _submitMutex;
+    QQueue<Transfer*> _submitted;
+    //hosts that answered with an ICMP error during this run
+    QSet<quint32> _unreachableHosts;
+    //members below are accessed only from the dispatcher thread
+    QVector<quint16> _localPorts;
+    QVector<int> _load;
+    QQueue<Transfer*> _waiting;
+    QHash<TransferKey, Transfer*> _transfers;
+    //TIDs of the transfers that are over, with their expiry time; a zero
+    //remote TID fences a local port after a request timed out unanswered
+    QHash<TransferKey, qint64> _closedTids;
+    QQueue<QPair<qint64, TransferKey> > _closedOrder;
+    AimdController _aimd;
+};
@@ -1,19 +1,147 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QCommandLineParser>
+#include <QDebug>
 #include "tftpclient.h"
+#include "statsmerge.h"
+#include "resultstore.h"
+
+static QCommandLineOption shardOption()
+{
+    return QCommandLineOption("shard", QCoreApplication::translate("main",
+                              "Sweep only slice <i> out of <n> of the addresses, i from 1 to n."), "i/n");
+}
+
+static QCommandLineOption mergeOption()
+{
+    return QCommandLineOption("merge", QCoreApplication::translate("main",
+                              "Merge the stats of the shards found in <inputs> into <output> and exit."), "output");
+}
+
+static QCommandLineOption csvOption()
+{
+    return QCommandLineOption("csv", QCoreApplication::translate("main",
+                              "Export the results journals <inputs> as CSV into <output> and exit."), "output");
+}
+
+static void addOptions(QCommandLineParser *parser)
+{
+    parser->addHelpOption();
+    parser->addOption(shardOption());
+    parser->addOption(mergeOption());
+    parser->addOption(csvOption());
+    parser->addPositionalArgument("inputs", QCoreApplication::translate("main",
+                                  "With --merge or --csv: stats files, results journals or working folders of the shards."),
+                                  "[inputs...]");
+}
+
+static void setApplicationNames(QCoreApplication *app)
+{
+    //the headless modes share the settings of the GUI
+    app->setApplicationName("TTFP Client");
+    app->setOrganizationName("VoIP");
+    app->setOrganizationDomain("Comms");
+}
+
+static bool parseShard(const QString &value, int *shardIndex, int *shardCount)
+{
+    const QStringList tok = value.split('/');
+    bool indexOk = false;
+    bool countOk = false;
+    if (2 == tok.size()) {
+        *shardIndex = tok.at(0).toInt(&indexOk) - 1;
+        *shardCount = tok.at(1).toInt(&countOk);
+    }
+    return indexOk && countOk && (0 <= *shardIndex) && (*shardCount > *shardIndex);
+}
+
+//a shard sweeps with the saved settings and exits when done
+static int shardMain(QCoreApplication *app, const QString &shard)
+{
+    int shardIndex = 0;
+    int shardCount = 1;
+    if (!parseShard(shard, &shardIndex, &shardCount)) {
+        qCritical() << "Invalid shard" << shard << ", expected i/n with i from 1 to n";
+        return 1;
+    }
+    TftpClient client;
+    client.setShard(shardIndex, shardCount);
+    if (!client.parseAddressList()) {
+        qCritical() << "Invalid address list" << client.property("hosts").toString();
+        return 1;
+    }
+    bool failed = false;
+    QObject::connect(&client, &TftpClient::error, app, [&failed](const QString &title, const QString &msg) {
+        qCritical().noquote() << title << ":" << msg;
+        failed = true;
+    });
+    QObject::connect(&client, &TftpClient::info, app, [](const QString &msg) {
+        qInfo().noquote() << msg;
+    });
+    QObject::connect(&client, &TftpClient::runningChanged, app, [&client]() {
+        if (!client.running()) {
+            QCoreApplication::quit();
+        }
+    });
+    client.startDownload();
+    app->exec();
+    return failed ? 1 : 0;
+}
+
+//sharded sweeps, merging the shard reports and exporting the journals need no GUI
+static int headlessMain(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    setApplicationNames(&app);
+    QCommandLineParser parser;
+    addOptions(&parser);
+    parser.process(app);
+    if (parser.isSet("shard")) {
+        return shardMain(&app, parser.value("shard"));
+    }
+    const QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty()) {
+        parser.showHelp(1);
+    }
+    QString msg;
+    if (parser.isSet("merge") && !mergeStats(inputs, parser.value("merge"), &msg)) {
+        qCritical() << msg;
+        return 1;
+    }
+    if (parser.isSet("csv") && !ResultStore::exportCsv(inputs, parser.value("csv"), &msg)) {
+        qCritical() << msg;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    //the kind of application depends on the options, which are parsed again
+    //by the application itself to report errors and show the help
+    QStringList args;
+    for (int i = 0; i < argc; ++i) {
+        args.append(QString::fromLocal8Bit(argv[i]));
+    }
+    QCommandLineParser preParser;
+    addOptions(&preParser);
+    preParser.parse(args);
+    if (preParser.isSet("shard") || preParser.isSet("merge") || preParser.isSet("csv")) {
+        return headlessMain(argc, argv);
+    }
+
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
     QGuiApplication app(argc, argv);
-    app.setApplicationName("TTFP Client");
-    app.setOrganizationName("VoIP");
-    app.setOrganizationDomain("Comms");
+    setApplicationNames(&app);
 
     qSetMessagePattern("%{appname} [%{threadid}] [%{type}] %{message} (%{file}:%{line})");
 
+    QCommandLineParser parser;
+    addOptions(&parser);
+    parser.process(app);
+
     QQmlApplicationEngine engine;
     QQmlContext *context = engine.rootContext();
     if (nullptr != context) {
@@ -0,0 +1,188 @@
+#ifdef USE_MMSG_TRANSPORT
+
+#include "mmsgtransport.h"
+#include "udptransport.h"
+#include <QDebug>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+MmsgTransport::~MmsgTransport()
+{
+    close();
+}
+
+bool MmsgTransport::open(int numSockets)
+{
+    close();
+    for (int s = 0; s < numSockets; ++s) {
+        Socket *socket = new Socket();
+        _sockets.append(socket);
+        socket->descriptor = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in name;
+        memset(&name, 0, sizeof(name));
+        name.sin_family = AF_INET;
+        name.sin_addr.s_addr = htonl(INADDR_ANY);
+        socklen_t nameLen = sizeof(name);
+        if ((0 > socket->descriptor) ||
+                (0 > bind(socket->descriptor, reinterpret_cast<const sockaddr*>(&name), sizeof(name))) ||
+                (0 > getsockname(socket->descriptor, reinterpret_cast<sockaddr*>(&name), &nameLen))) {
+            qCritical() << "Cannot bind socket" << s << ":" << strerror(errno);
+            close();
+            return false;
+        }
+        socket->port = ntohs(name.sin_port);
+        //unconnected sockets report ICMP errors only through the error queue
+        const int on = 1;
+        setsockopt(socket->descriptor, SOL_IP, IP_RECVERR, &on, sizeof(on));
+        prepare(&socket->in);
+        prepare(&socket->out);
+    }
+    _clock.start();
+    return !_sockets.isEmpty();
+}
+
+void MmsgTransport::close()
+{
+    for (Socket *socket: _sockets) {
+        if (0 <= socket->descriptor) {
+            ::close(socket->descriptor);
+        }
+    }
+    qDeleteAll(_sockets);
+    _sockets.clear();
+}
+
+quint16 MmsgTransport::localPort(int s) const
+{
+    return _sockets.at(s)->port;
+}
+
+QString MmsgTransport::errorString(int s) const
+{
+    return QString::fromLocal8Bit(strerror(_sockets.at(s)->error));
+}
+
+bool MmsgTransport::send(int s, const QByteArray &data, const QHostAddress &host,
+                         quint16 port)
+{
+    Socket *socket = _sockets.at(s);
+    bool isIPv4 = false;
+    const quint32 address = host.toIPv4Address(&isIPv4);
+    if (!isIPv4) {
+        socket->error = EAFNOSUPPORT;
+        return false;
+    }
+    if (DATAGRAM_SIZE < data.size()) {
+        socket->error = EMSGSIZE;
+        return false;
+    }
+    Batch &out = socket->out;
+    if (BATCH_SIZE == out.count) {
+        flush(socket);
+    }
+    const int n = out.count++;
+    memcpy(out.buffers[n], data.constData(), static_cast<size_t>(data.size()));
+    out.iovs[n].iov_len = static_cast<size_t>(data.size());
+    out.names[n].sin_port = htons(port);
+    out.names[n].sin_addr.s_addr = htonl(address);
+    return true;
+}
+
+bool MmsgTransport::receive(int s, Datagram *datagram)
+{
+    Socket *socket = _sockets.at(s);
+    Batch &in = socket->in;
+    if (in.next >= in.count) {
+        //refill the whole batch with one call
+        for (int n = 0; n < BATCH_SIZE; ++n) {
+            in.msgs[n].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        const int count = recvmmsg(socket->descriptor, in.msgs, BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        in.next = 0;
+        in.count = qMax(0, count);
+        if (0 == in.count) {
+            if ((0 > count) && (EAGAIN != errno) && (EWOULDBLOCK != errno)) {
+                socket->error = errno;
+            }
+            return UdpTransport::receiveError(socket->descriptor, datagram);
+        }
+    }
+    const int n = in.next++;
+    const int len = static_cast<int>(in.msgs[n].msg_len);
+    datagram->data.resize(len);
+    memcpy(datagram->data.data(), in.buffers[n], static_cast<size_t>(len));
+    datagram->sender.setAddress(ntohl(in.names[n].sin_addr.s_addr));
+    datagram->senderPort = ntohs(in.names[n].sin_port);
+    datagram->unreachable = false;
+    return true;
+}
+
+void MmsgTransport::flush()
+{
+    for (Socket *socket: _sockets) {
+        flush(socket);
+    }
+}
+
+void MmsgTransport::flush(Socket *socket)
+{
+    Batch &out = socket->out;
+    int sent = 0;
+    bool retried = false;
+    while (sent < out.count) {
+        const int n = sendmmsg(socket->descriptor, out.msgs + sent,
+                               static_cast<unsigned int>(out.count - sent), 0);
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            //an ICMP error received for any transfer also fails the next send once
+            if (!retried) {
+                retried = true;
+                continue;
+            }
+            //only the failing datagram is lost, its transfer times out
+            socket->error = errno;
+            qWarning() << "Cannot send datagram :" << strerror(errno);
+            ++sent;
+        } else {
+            sent += n;
+        }
+        retried = false;
+    }
+    out.count = 0;
+}
+
+void MmsgTransport::wait(int timeoutMs)
+{
+    //unlike QUdpSocket all the sockets are watched at once
+    QVector<pollfd> fds(_sockets.size());
+    for (int s = 0; s < _sockets.size(); ++s) {
+        fds[s].fd = _sockets.at(s)->descriptor;
+        fds[s].events = POLLIN;
+        fds[s].revents = 0;
+    }
+    poll(fds.data(), static_cast<nfds_t>(_sockets.size()), timeoutMs);
+}
+
+void MmsgTransport::prepare(Batch *batch)
+{
+    memset(batch->msgs, 0, sizeof(batch->msgs));
+    memset(batch->names, 0, sizeof(batch->names));
+    for (int n = 0; n < BATCH_SIZE; ++n) {
+        batch->iovs[n].iov_base = batch->buffers[n];
+        batch->iovs[n].iov_len = DATAGRAM_SIZE;
+        batch->names[n].sin_family = AF_INET;
+        batch->msgs[n].msg_hdr.msg_name = &batch->names[n];
+        batch->msgs[n].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        batch->msgs[n].msg_hdr.msg_iov = &batch->iovs[n];
+        batch->msgs[n].msg_hdr.msg_iovlen = 1;
+    }
+    batch->count = 0;
+    batch->next = 0;
+}
+
+#endif
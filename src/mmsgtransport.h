@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef USE_MMSG_TRANSPORT
+
+#include "transport.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+//Linux transport that batches the socket calls of all transfers: received
+//datagrams are read with one recvmmsg per socket into preallocated buffers,
+//sent datagrams are queued and handed to sendmmsg when the dispatcher flushes
+class MmsgTransport : public Transport
+{
+public:
+    enum { BATCH_SIZE = 64, DATAGRAM_SIZE = 1472 };
+    ~MmsgTransport() override;
+    bool open(int numSockets) override;
+    void close() override;
+    int socketCount() const override { return _sockets.size(); }
+    quint16 localPort(int s) const override;
+    QString errorString(int s) const override;
+    bool send(int s, const QByteArray &data, const QHostAddress &host,
+              quint16 port) override;
+    bool receive(int s, Datagram *datagram) override;
+    void flush() override;
+    void wait(int timeoutMs) override;
+    qint64 now() const override { return _clock.elapsed(); }
+private:
+    struct Batch {
+        mmsghdr msgs[BATCH_SIZE];
+        iovec iovs[BATCH_SIZE];
+        sockaddr_in names[BATCH_SIZE];
+        char buffers[BATCH_SIZE][DATAGRAM_SIZE];
+        int count = 0;
+        int next = 0;
+    };
+    struct Socket {
+        int descriptor = -1;
+        quint16 port = 0;
+        int error = 0;
+        Batch in;
+        Batch out;
+    };
+    static void prepare(Batch *batch);
+    void flush(Socket *socket);
+
+    QVector<Socket*> _sockets;
+    QElapsedTimer _clock;
+};
+
+#endif
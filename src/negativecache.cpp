@@ -0,0 +1,112 @@
+#include "negativecache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+bool NegativeCache::load(const QString &fileName)
+{
+    QMutexLocker locker(&_mutex);
+    _now = QDateTime::currentSecsSinceEpoch();
+    _hosts.clear();
+    _files.clear();
+    if (!enabled()) {
+        return true;
+    }
+
+    QFile ifile(fileName);
+    if (!ifile.exists()) {
+        return true;
+    }
+    if (!ifile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot open" << fileName;
+        return false;
+    }
+    QDataStream in(&ifile);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if ((MAGIC != magic) || (VERSION != version)) {
+        qWarning() << "Ignoring negative cache with unknown format" << fileName;
+        return true;
+    }
+    in >> _hosts >> _files;
+    if (QDataStream::Ok != in.status()) {
+        qWarning() << "Ignoring corrupted negative cache" << fileName;
+        _hosts.clear();
+        _files.clear();
+        return true;
+    }
+
+    for (auto it = _hosts.begin(); it != _hosts.end();) {
+        it = (it.value() <= _now) ? _hosts.erase(it) : (it + 1);
+    }
+    for (auto it = _files.begin(); it != _files.end();) {
+        it = (it.value() <= _now) ? _files.erase(it) : (it + 1);
+    }
+    qInfo() << "Negative cache:" << _hosts.size() << "hosts," << _files.size() << "files";
+    return true;
+}
+
+bool NegativeCache::save(const QString &fileName)
+{
+    QMutexLocker locker(&_mutex);
+    if (!enabled()) {
+        return true;
+    }
+    //an interrupted write keeps the previous cache
+    QSaveFile ofile(fileName);
+    if (!ofile.open(QIODevice::WriteOnly)) {
+        qCritical() << "Cannot open file for writing" << fileName;
+        return false;
+    }
+    QDataStream out(&ofile);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << static_cast<quint32>(MAGIC) << static_cast<quint32>(VERSION) << _hosts << _files;
+    return ofile.commit();
+}
+
+bool NegativeCache::containsHost(quint32 address) const
+{
+    QMutexLocker locker(&_mutex);
+    return _hosts.value(address, 0) > _now;
+}
+
+bool NegativeCache::containsFile(quint32 address, const QString &filename) const
+{
+    const quint64 key = fileKey(address, filename);
+    QMutexLocker locker(&_mutex);
+    return _files.value(key, 0) > _now;
+}
+
+void NegativeCache::addHost(quint32 address)
+{
+    if (!enabled()) {
+        return;
+    }
+    QMutexLocker locker(&_mutex);
+    _hosts.insert(address, _now + _ttlSecs);
+}
+
+void NegativeCache::addFile(quint32 address, const QString &filename)
+{
+    if (!enabled()) {
+        return;
+    }
+    const quint64 key = fileKey(address, filename);
+    QMutexLocker locker(&_mutex);
+    _files.insert(key, _now + _ttlSecs);
+}
+
+quint64 NegativeCache::fileKey(quint32 address, const QString &filename)
+{
+    //qHash() is seeded per process, the key must be stable across runs
+    quint32 hash = 2166136261u;
+    const QByteArray bytes = filename.toUtf8();
+    for (const char c: bytes) {
+        hash = (hash ^ static_cast<uchar>(c)) * 16777619u;
+    }
+    return (static_cast<quint64>(address) << 32) | hash;
+}
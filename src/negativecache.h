@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+//hosts that did not answer and files that were not found during the last
+//sweeps, kept on disk so that the next sweeps skip them until they expire
+class NegativeCache
+{
+public:
+    //a zero TTL disables the cache
+    void setTtl(int secs) { _ttlSecs = secs; }
+    bool enabled() const { return 0 < _ttlSecs; }
+    //drops the expired entries, a missing file gives an empty cache
+    bool load(const QString &fileName);
+    bool save(const QString &fileName);
+    bool containsHost(quint32 address) const;
+    bool containsFile(quint32 address, const QString &filename) const;
+    void addHost(quint32 address);
+    void addFile(quint32 address, const QString &filename);
+private:
+    enum { MAGIC = 0x4e434143, VERSION = 1 };
+    static quint64 fileKey(quint32 address, const QString &filename);
+
+    mutable QMutex _mutex;
+    int _ttlSecs = 0;
+    qint64 _now = 0;
+    //expiry time in seconds since epoch
+    QHash<quint32, qint64> _hosts;
+    QHash<quint64, qint64> _files;
+};
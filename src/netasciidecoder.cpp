@@ -0,0 +1,209 @@
+#include "netasciidecoder.h"
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (2 <= _M_IX86_FP))
+#include <immintrin.h>
+#define NETASCII_SSE2
+//SSE2 is the baseline, the AVX2 search is built for any target and only
+//selected at run time on CPUs that have it
+#if defined(__AVX2__) || defined(_MSC_VER)
+#define NETASCII_AVX2
+#define NETASCII_TARGET_AVX2
+#elif defined(__GNUC__)
+#define NETASCII_AVX2
+#define NETASCII_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef const char *(*FindCr)(const char *begin, const char *end);
+
+static const char *findCrScalar(const char *p, const char *end)
+{
+    while ((p < end) && ('\r' != *p)) {
+        ++p;
+    }
+    return p;
+}
+
+#ifdef NETASCII_SSE2
+static inline int firstBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static const char *findCrSse2(const char *p, const char *end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; p + 16 <= end; p += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned int mask = static_cast<unsigned int>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr)));
+        if (0 != mask) {
+            return p + firstBit(mask);
+        }
+    }
+    return findCrScalar(p, end);
+}
+#endif
+
+#ifdef NETASCII_AVX2
+NETASCII_TARGET_AVX2 static const char *findCrAvx2(const char *p, const char *end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    for (; p + 32 <= end; p += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned int mask = static_cast<unsigned int>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr)));
+        if (0 != mask) {
+            return p + firstBit(mask);
+        }
+    }
+    return findCrSse2(p, end);
+}
+
+static bool hasAvx2()
+{
+#if defined(__AVX2__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (7 > info[0]) {
+        return false;
+    }
+    //the OS must also save the YMM registers on context switches
+    __cpuid(info, 1);
+    const int osxsaveAvx = (1 << 27) | (1 << 28);
+    if ((osxsaveAvx != (info[2] & osxsaveAvx)) || (6 != (_xgetbv(0) & 6))) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return 0 != (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return 0 != __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static FindCr selectFindCr()
+{
+#if defined(NETASCII_AVX2)
+    return hasAvx2() ? findCrAvx2 : findCrSse2;
+#elif defined(NETASCII_SSE2)
+    return findCrSse2;
+#else
+    return findCrScalar;
+#endif
+}
+
+void NetasciiDecoder::decode(const char *data, int size, QByteArray *out)
+{
+    //the output is never longer than the input plus a pending CR
+    const int offset = out->size();
+    out->resize(offset + size + 1);
+    char *dst = out->data() + offset;
+    const char *src = data;
+    const char *end = data + size;
+
+    if (_pendingCr && (src < end)) {
+        _pendingCr = false;
+        if ('\n' == *src) {
+            *dst++ = '\n';
+            ++src;
+        } else if ('\0' == *src) {
+            *dst++ = '\r';
+            ++src;
+        } else {
+            *dst++ = '\r';
+        }
+    }
+    while (src < end) {
+        //text between two CRs is copied as a whole
+        const char *cr = findCr(src, end);
+        const size_t len = static_cast<size_t>(cr - src);
+        memcpy(dst, src, len);
+        dst += len;
+        src = cr;
+        if (src == end) {
+            break;
+        }
+        if (src + 1 == end) {
+            _pendingCr = true;
+            ++src;
+            break;
+        }
+        if ('\n' == src[1]) {
+            *dst++ = '\n';
+            src += 2;
+        } else if ('\0' == src[1]) {
+            *dst++ = '\r';
+            src += 2;
+        } else {
+            *dst++ = '\r';
+            ++src;
+        }
+    }
+    out->resize(static_cast<int>(dst - out->data()));
+}
+
+void NetasciiDecoder::decodeScalar(const char *data, int size, QByteArray *out)
+{
+    const int offset = out->size();
+    out->resize(offset + size + 1);
+    char *dst = out->data() + offset;
+    for (int i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (_pendingCr) {
+            _pendingCr = false;
+            if ('\n' == c) {
+                *dst++ = '\n';
+                continue;
+            }
+            *dst++ = '\r';
+            if ('\0' == c) {
+                continue;
+            }
+        }
+        if ('\r' == c) {
+            _pendingCr = true;
+        } else {
+            *dst++ = c;
+        }
+    }
+    out->resize(static_cast<int>(dst - out->data()));
+}
+
+void NetasciiDecoder::finish(QByteArray *out)
+{
+    if (_pendingCr) {
+        out->append('\r');
+        _pendingCr = false;
+    }
+}
+
+const char *NetasciiDecoder::instructionSet()
+{
+#if defined(NETASCII_AVX2)
+    return hasAvx2() ? "AVX2" : "SSE2";
+#elif defined(NETASCII_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+const char *NetasciiDecoder::findCr(const char *begin, const char *end)
+{
+    //the CPU is probed once, by the first decoded block
+    static const FindCr search = selectFindCr();
+    return search(begin, end);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QByteArray>
+
+//streaming netascii to local text translation (RFC 764): CR LF becomes LF and
+//CR NUL becomes CR, a CR at the end of a block is resolved by the next one;
+//the CR search uses AVX2 when the CPU has it, SSE2 otherwise
+class NetasciiDecoder
+{
+public:
+    void reset() { _pendingCr = false; }
+    //appends the translation of the next chunk of the stream
+    void decode(const char *data, int size, QByteArray *out);
+    //byte by byte reference, same output as decode()
+    void decodeScalar(const char *data, int size, QByteArray *out);
+    //a CR that ends the stream is kept as is
+    void finish(QByteArray *out);
+    static const char *instructionSet();
+private:
+    static const char *findCr(const char *begin, const char *end);
+
+    bool _pendingCr = false;
+};
@@ -0,0 +1,164 @@
+#include "requestplan.h"
+#include <QFile>
+#include <QObject>
+#include <QTextStream>
+
+bool RequestPlan::compile(const QString &prefix, const QString &files,
+                          const QString &extension, QString *error)
+{
+    _entries.clear();
+    const QString ext = extension.isEmpty() ? QString() : ("." + extension);
+
+    if (!QFile::exists(files)) {
+        //assume that this is the filename to be downloaded
+        _entries.append(compileEntry(prefix + files + ext, _mode));
+        return true;
+    }
+
+    //got list of files
+    QFile ifile(files);
+    if (!ifile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QObject::tr("Cannot open ") + ifile.fileName();
+        return false;
+    }
+    QTextStream in(&ifile);
+    while (!in.atEnd()) {
+        _entries.append(compileEntry(prefix + in.readLine().trimmed() + ext, _mode));
+    }
+    return true;
+}
+
+void RequestPlan::render(int n, quint32 address, QString *filename,
+                         QByteArray *packet) const
+{
+    renderEntry(_entries.at(n), address, _mode, filename, packet);
+}
+
+QStringList RequestPlan::patterns() const
+{
+    QStringList out;
+    for (const auto &entry: _entries) {
+        out.append(entry.pattern);
+    }
+    return out;
+}
+
+QString RequestPlan::expand(const QString &pattern, quint32 address)
+{
+    QString filename;
+    QByteArray packet;
+    renderEntry(compileEntry(pattern, "octet"), address, "octet", &filename, &packet);
+    return filename;
+}
+
+void RequestPlan::renderEntry(const Entry &entry, quint32 address, const QByteArray &mode,
+                              QString *filename, QByteArray *packet)
+{
+    if (entry.isStatic) {
+        *filename = entry.filename;
+        *packet = entry.packet;
+        return;
+    }
+    filename->resize(0);
+    for (const auto &seg: entry.segments) {
+        switch (seg.type) {
+        case Literal:
+            filename->append(seg.text);
+            break;
+        case Ip:
+            appendNumber(filename, (address >> 24) & 0xff, 10, 1);
+            filename->append(QLatin1Char('.'));
+            appendNumber(filename, (address >> 16) & 0xff, 10, 1);
+            filename->append(QLatin1Char('.'));
+            appendNumber(filename, (address >> 8) & 0xff, 10, 1);
+            filename->append(QLatin1Char('.'));
+            appendNumber(filename, address & 0xff, 10, 1);
+            break;
+        case IpHex:
+            //as used by PXE and most provisioning servers, e.g. C0A80001
+            appendNumber(filename, address, 16, 8);
+            break;
+        case LastOctet:
+            appendNumber(filename, address & 0xff, 10, 1);
+            break;
+        }
+    }
+    encodeRrq(*filename, mode, packet);
+}
+
+void RequestPlan::appendNumber(QString *out, quint32 value, quint32 base, int width)
+{
+    //formatted in place, QString::number() would allocate a temporary
+    static const char digits[] = "0123456789ABCDEF";
+    QChar buffer[32];
+    int pos = 32;
+    do {
+        buffer[--pos] = QLatin1Char(digits[value % base]);
+        value /= base;
+    } while ((0 != value) || (32 - pos < width));
+    out->append(buffer + pos, 32 - pos);
+}
+
+QByteArray RequestPlan::rrqPacket(const QString &filename, const QByteArray &mode)
+{
+    QByteArray byteArray;
+    encodeRrq(filename, mode, &byteArray);
+    return byteArray;
+}
+
+RequestPlan::Entry RequestPlan::compileEntry(const QString &pattern, const QByteArray &mode)
+{
+    Entry entry;
+    entry.pattern = pattern;
+    int pos = 0;
+    while (pos < pattern.size()) {
+        int open = pattern.indexOf('{', pos);
+        const int close = (0 > open) ? -1 : pattern.indexOf('}', open);
+        if (0 <= close) {
+            //the innermost name, a stray brace before it is literal
+            open = pattern.lastIndexOf('{', close);
+        }
+        Segment seg = {Literal, QString()};
+        if (0 <= close) {
+            const QString name = pattern.mid(open + 1, close - open - 1);
+            if ("ip" == name) {
+                seg.type = Ip;
+            } else if ("ip_hex" == name) {
+                seg.type = IpHex;
+            } else if ("last_octet" == name) {
+                seg.type = LastOctet;
+            }
+        }
+        if (Literal == seg.type) {
+            //unknown names are kept verbatim
+            const int end = (0 <= close) ? (close + 1) : pattern.size();
+            seg.text = pattern.mid(pos, end - pos);
+            pos = end;
+        } else {
+            if (open > pos) {
+                const Segment literal = {Literal, pattern.mid(pos, open - pos)};
+                entry.segments.append(literal);
+            }
+            entry.isStatic = false;
+            pos = close + 1;
+        }
+        entry.segments.append(seg);
+    }
+    if (entry.isStatic) {
+        entry.filename = pattern;
+        encodeRrq(entry.filename, mode, &entry.packet);
+    }
+    return entry;
+}
+
+void RequestPlan::encodeRrq(const QString &filename, const QByteArray &mode,
+                            QByteArray *packet)
+{
+    packet->resize(0);
+    packet->append(static_cast<char>(0x00));
+    packet->append(static_cast<char>(0x01)); // OPCODE
+    packet->append(filename.toLatin1());
+    packet->append(static_cast<char>(0x00));
+    packet->append(mode); // MODE
+    packet->append(static_cast<char>(0x00));
+}
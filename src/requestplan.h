@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//filenames and RRQ packets compiled once per sweep and shared by all hosts;
+//{ip}, {ip_hex} and {last_octet} in the prefix, suffixes or extension are
+//replaced with the address of the host being queried
+class RequestPlan
+{
+public:
+    //octet or netascii, must be set before compiling
+    void setMode(const QByteArray &mode) { _mode = mode; }
+    bool compile(const QString &prefix, const QString &files,
+                 const QString &extension, QString *error);
+    int size() const { return _entries.size(); }
+    //unexpanded filename of each entry
+    QStringList patterns() const;
+    static QString expand(const QString &pattern, quint32 address);
+    //entries without placeholders share their precompiled data, the others
+    //are rendered into the given buffers, which keep their capacity
+    void render(int n, quint32 address, QString *filename, QByteArray *packet) const;
+    static QByteArray rrqPacket(const QString &filename, const QByteArray &mode = "octet");
+private:
+    enum SegmentType { Literal, Ip, IpHex, LastOctet };
+    struct Segment {
+        SegmentType type;
+        QString text;
+    };
+    struct Entry {
+        QString pattern;
+        QVector<Segment> segments;
+        bool isStatic = true;
+        QString filename;
+        QByteArray packet;
+    };
+    static Entry compileEntry(const QString &pattern, const QByteArray &mode);
+    static void renderEntry(const Entry &entry, quint32 address, const QByteArray &mode,
+                            QString *filename, QByteArray *packet);
+    //uppercase digits, left padded with zeros to width
+    static void appendNumber(QString *out, quint32 value, quint32 base, int width);
+    static void encodeRrq(const QString &filename, const QByteArray &mode, QByteArray *packet);
+
+    QByteArray _mode = "octet";
+    QVector<Entry> _entries;
+};
@@ -0,0 +1,198 @@
+#include "resultstore.h"
+#include "requestplan.h"
+#include <QHostAddress>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QTextStream>
+#include <QDebug>
+
+bool ResultStore::open(const QString &fileName, const QString &workingFolder,
+                       const QStringList &names)
+{
+    QMutexLocker locker(&_mutex);
+    _downloaded = 0;
+    _pending = 0;
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical() << "Cannot open file for writing" << fileName;
+        return false;
+    }
+    _stream.setDevice(&_file);
+    _stream.setVersion(QDataStream::Qt_5_0);
+    _stream << static_cast<quint32>(MAGIC) << static_cast<quint32>(VERSION)
+            << workingFolder << names;
+    _file.flush();
+    return QDataStream::Ok == _stream.status();
+}
+
+void ResultStore::append(const Record &record)
+{
+    if ((Downloaded == record.status) || (Unchanged == record.status)) {
+        ++_downloaded;
+    }
+    QMutexLocker locker(&_mutex);
+    if (!_file.isOpen()) {
+        return;
+    }
+    _stream << record.address << record.name << record.status << record.size
+            << record.durationMs;
+    if (FLUSH_INTERVAL <= ++_pending) {
+        _file.flush();
+        _pending = 0;
+    }
+}
+
+bool ResultStore::close()
+{
+    QMutexLocker locker(&_mutex);
+    if (!_file.isOpen()) {
+        return false;
+    }
+    const bool rc = (QDataStream::Ok == _stream.status()) && _file.flush();
+    _stream.setDevice(nullptr);
+    _file.close();
+    return rc;
+}
+
+bool ResultStore::read(const QString &fileName, QString *workingFolder, QStringList *names,
+                       const Visitor &visitor, QString *error)
+{
+    QFile ifile(fileName);
+    if (!ifile.open(QIODevice::ReadOnly)) {
+        *error = QObject::tr("Cannot open ") + fileName;
+        return false;
+    }
+    QDataStream in(&ifile);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if ((MAGIC != magic) || (VERSION != version)) {
+        *error = QObject::tr("Unknown results format ") + fileName;
+        return false;
+    }
+    in >> *workingFolder >> *names;
+    if (QDataStream::Ok != in.status()) {
+        *error = QObject::tr("Truncated results header ") + fileName;
+        return false;
+    }
+    Record record;
+    while (!in.atEnd()) {
+        in >> record.address >> record.name >> record.status >> record.size
+           >> record.durationMs;
+        if (QDataStream::Ok != in.status()) {
+            qWarning() << "Truncated record at the end of" << fileName;
+            break;
+        }
+        visitor(record);
+    }
+    return true;
+}
+
+bool ResultStore::readDownloaded(const QString &fileName, QMap<quint32, QString> *stats,
+                                 QString *error)
+{
+    QString workingFolder;
+    QStringList names;
+    //a host may have several files, the last one is reported as before
+    QSet<quint32> seen;
+    return read(fileName, &workingFolder, &names, [&](const Record &record) {
+        if ((Downloaded != record.status) && (Unchanged != record.status)) {
+            return;
+        }
+        const QString address = QHostAddress(record.address).toString();
+        if (stats->contains(record.address) && !seen.contains(record.address)) {
+            qWarning() << "Address found in several journals" << address;
+        }
+        seen.insert(record.address);
+        stats->insert(record.address, workingFolder + "/" + address + "/" +
+                      filename(names, record));
+    }, error);
+}
+
+bool ResultStore::exportStats(const QStringList &fileNames, const QString &output,
+                              QString *error)
+{
+    //only the downloaded files are kept in memory
+    QMap<quint32, QString> stats;
+    for (const auto &fileName: fileNames) {
+        if (!readDownloaded(fileName, &stats, error)) {
+            return false;
+        }
+    }
+
+    QFile ofile(output);
+    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        *error = QObject::tr("Cannot open file for writing ") + output;
+        return false;
+    }
+    QTextStream stream(&ofile);
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+        stream << QHostAddress(it.key()).toString() << ": " << it.value() << endl;
+    }
+    return true;
+}
+
+bool ResultStore::exportCsv(const QStringList &fileNames, const QString &output,
+                            QString *error)
+{
+    QFile ofile(output);
+    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        *error = QObject::tr("Cannot open file for writing ") + output;
+        return false;
+    }
+    QTextStream stream(&ofile);
+    stream << "address,filename,status,size,duration_ms" << endl;
+    for (const auto &fileName: fileNames) {
+        QString workingFolder;
+        QStringList names;
+        const bool rc = read(fileName, &workingFolder, &names, [&](const Record &record) {
+            //quoted, a filename may contain commas or quotes
+            QString name = filename(names, record);
+            name.replace('"', "\"\"");
+            stream << QHostAddress(record.address).toString() << ",\"" << name << "\","
+                   << statusName(record.status) << ',' << record.size << ','
+                   << record.durationMs << '\n';
+        }, error);
+        if (!rc) {
+            return false;
+        }
+    }
+    stream.flush();
+    return true;
+}
+
+QString ResultStore::statusName(quint8 status)
+{
+    switch (status) {
+    case Downloaded:
+        return "downloaded";
+    case NotFound:
+        return "not found";
+    case ServerError:
+        return "server error";
+    case Timeout:
+        return "timeout";
+    case Unreachable:
+        return "unreachable";
+    case Unchanged:
+        return "unchanged";
+    case Cancelled:
+        return "cancelled";
+    case SendFailed:
+        return "send failed";
+    case WriteFailed:
+        return "write failed";
+    }
+    return "unknown";
+}
+
+QString ResultStore::filename(const QStringList &names, const Record &record)
+{
+    if (names.size() <= static_cast<qint64>(record.name)) {
+        return QString();
+    }
+    const QString &name = names.at(static_cast<int>(record.name));
+    return name.contains('{') ? RequestPlan::expand(name, record.address) : name;
+}
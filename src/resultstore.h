@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QDataStream>
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+
+//append-only binary journal of the sweep results: a header with the working
+//folder and the filename table, then one fixed size record per outcome,
+//flushed as the sweep goes so that a crash loses at most a few records
+class ResultStore
+{
+public:
+    //Unchanged: downloaded by an incremental sweep, identical to the file on disk
+    //SendFailed: the local socket refused to send, WriteFailed: the file could not be saved
+    enum Status { Downloaded, NotFound, ServerError, Timeout, Unreachable, Unchanged,
+                  Cancelled, SendFailed, WriteFailed };
+    enum { FLUSH_INTERVAL = 256 };
+    struct Record {
+        quint32 address;
+        //index in the filename table
+        quint32 name;
+        quint8 status;
+        quint32 size;
+        quint32 durationMs;
+    };
+    typedef std::function<void(const Record &record)> Visitor;
+
+    //names may contain the placeholders of the request plan
+    bool open(const QString &fileName, const QString &workingFolder,
+              const QStringList &names);
+    //thread safe
+    void append(const Record &record);
+    bool close();
+    //including the unchanged files
+    int downloaded() const { return _downloaded; }
+
+    //streams the records of a journal, stops at a truncated record
+    static bool read(const QString &fileName, QString *workingFolder, QStringList *names,
+                     const Visitor &visitor, QString *error);
+    //adds the path of the downloaded files of a journal to stats, by address
+    static bool readDownloaded(const QString &fileName, QMap<quint32, QString> *stats,
+                               QString *error);
+    //address: path lines of the downloaded files, sorted by address
+    static bool exportStats(const QStringList &fileNames, const QString &output,
+                            QString *error);
+    static bool exportCsv(const QStringList &fileNames, const QString &output,
+                          QString *error);
+    static QString statusName(quint8 status);
+    static QString filename(const QStringList &names, const Record &record);
+private:
+    enum { MAGIC = 0x54465253, VERSION = 1 };
+
+    QMutex _mutex;
+    QFile _file;
+    QDataStream _stream;
+    int _pending = 0;
+    std::atomic<int> _downloaded{0};
+};
@@ -0,0 +1,268 @@
+#include "simtransport.h"
+
+SimTransport::SimTransport(quint32 seed, quint16 serverPort) :
+    _serverPort(serverPort), _rng(seed)
+{
+}
+
+void SimTransport::addHost(const QString &address, const HostScript &script)
+{
+    Host host;
+    host.script = script;
+    _hosts.insert(QHostAddress(address).toIPv4Address(), host);
+}
+
+bool SimTransport::open(int numSockets)
+{
+    close();
+    _inbox.resize(numSockets);
+    return 0 < numSockets;
+}
+
+void SimTransport::close()
+{
+    _inbox.clear();
+    _events.clear();
+    for (auto &host: _hosts) {
+        host.sessions.clear();
+    }
+}
+
+quint16 SimTransport::localPort(int s) const
+{
+    return static_cast<quint16>(FIRST_LOCAL_PORT + s);
+}
+
+bool SimTransport::send(int s, const QByteArray &data, const QHostAddress &host,
+                        quint16 port)
+{
+    bool isIPv4 = false;
+    const quint32 address = host.toIPv4Address(&isIPv4);
+    auto it = _hosts.find(address);
+    if (!isIPv4 || (_hosts.end() == it)) {
+        //nobody listens there, the datagram is silently lost
+        return true;
+    }
+    const Event ev = {Event::ToHost, address, localPort(s), port, data, false};
+    transmit(it.value(), ev);
+    return true;
+}
+
+bool SimTransport::receive(int s, Datagram *datagram)
+{
+    if (_inbox.at(s).isEmpty()) {
+        return false;
+    }
+    *datagram = _inbox[s].dequeue();
+    return true;
+}
+
+void SimTransport::wait(int timeoutMs)
+{
+    const qint64 deadline = _now + timeoutMs;
+    while (!hasPending() && !_events.isEmpty() && (_events.firstKey().first <= deadline)) {
+        auto it = _events.begin();
+        _now = qMax(_now, it.key().first);
+        const Event ev = it.value();
+        _events.erase(it);
+        deliver(ev);
+    }
+    if (!hasPending()) {
+        _now = deadline;
+    }
+}
+
+void SimTransport::advance(int ms)
+{
+    const qint64 deadline = _now + ms;
+    while (!_events.isEmpty() && (_events.firstKey().first <= deadline)) {
+        auto it = _events.begin();
+        _now = qMax(_now, it.key().first);
+        const Event ev = it.value();
+        _events.erase(it);
+        deliver(ev);
+    }
+    _now = deadline;
+}
+
+double SimTransport::random()
+{
+    //not std::uniform_real_distribution, whose output differs between libraries
+    return static_cast<double>(_rng() >> 8) / 16777216.0;
+}
+
+void SimTransport::schedule(qint64 time, const Event &ev)
+{
+    _events.insert(qMakePair(time, _seq++), ev);
+}
+
+void SimTransport::transmit(Host &host, const Event &ev)
+{
+    const HostScript &script = host.script;
+    const int index = host.datagramCount++;
+    //always draw the same number of values so that scripts stay comparable
+    const bool lost = random() < script.lossRate;
+    const bool duplicated = random() < script.duplicateRate;
+    if (script.dropped.contains(index) || lost) {
+        return;
+    }
+    const int copies = duplicated ? 2 : 1;
+    for (int n = 0; n < copies; ++n) {
+        const int jitter = static_cast<int>(random() * (script.jitterMs + 1));
+        schedule(_now + script.latencyMs + jitter, ev);
+    }
+}
+
+void SimTransport::deliver(const Event &ev)
+{
+    auto it = _hosts.find(ev.address);
+    switch (ev.type) {
+    case Event::ToHost:
+        if (_hosts.end() != it) {
+            serverReceive(it.value(), ev);
+        }
+        break;
+    case Event::ToSocket: {
+        const int s = ev.dstPort - FIRST_LOCAL_PORT;
+        if ((0 <= s) && (_inbox.size() > s)) {
+            Datagram datagram;
+            datagram.data = ev.data;
+            datagram.sender = QHostAddress(ev.address);
+            datagram.senderPort = ev.srcPort;
+            datagram.unreachable = ev.unreachable;
+            _inbox[s].enqueue(datagram);
+        }
+        break;
+    }
+    case Event::Retransmit: {
+        //source port is the server TID, destination port the block number
+        if (_hosts.end() == it) {
+            break;
+        }
+        Host &host = it.value();
+        auto sit = host.sessions.find(ev.srcPort);
+        if ((host.sessions.end() == sit) || (sit->block != ev.dstPort)) {
+            break;
+        }
+        if (host.script.maxRetransmits <= sit->retransmits) {
+            host.sessions.erase(sit);
+            break;
+        }
+        ++sit->retransmits;
+        sendBlock(host, ev.address, ev.srcPort, sit.value());
+        break;
+    }
+    }
+}
+
+void SimTransport::serverReceive(Host &host, const Event &ev)
+{
+    if ((4 > ev.data.size()) || (0x00 != ev.data.at(0))) {
+        return;
+    }
+    if (host.script.portClosed) {
+        //the error names the destination the datagram was sent to
+        const Event icmp = {Event::ToSocket, ev.address, ev.dstPort, ev.srcPort,
+                            QByteArray(), true};
+        schedule(_now + host.script.latencyMs, icmp);
+        return;
+    }
+    const char opCode = ev.data.at(1);
+
+    quint16 tid = ev.dstPort;
+    if ((_serverPort == ev.dstPort) && (0x01 != opCode)) {
+        if (!host.script.replyFromListenPort) {
+            return;
+        }
+        //the session is known by the client port only
+        tid = 0;
+        for (auto it = host.sessions.constBegin(); it != host.sessions.constEnd(); ++it) {
+            if (ev.srcPort == it->clientPort) {
+                tid = it.key();
+                break;
+            }
+        }
+    } else if (_serverPort == ev.dstPort) {
+        const QString filename = QString::fromLatin1(ev.data.constData() + 2);
+        const quint16 tid = _nextTid++;
+        auto fit = host.script.files.constFind(filename);
+        if (host.script.files.constEnd() == fit) {
+            QByteArray errByteArray("\x00\x05\x00\x01", 4);
+            errByteArray.append("File not found");
+            errByteArray.append(static_cast<char>(0x00));
+            serverSend(host, ev.address, tid, ev.srcPort, errByteArray);
+            return;
+        }
+        Session session;
+        session.clientPort = ev.srcPort;
+        session.file = fit.value();
+        session.block = 1;
+        host.sessions.insert(tid, session);
+        sendBlock(host, ev.address, tid, session);
+        return;
+    }
+
+    auto sit = host.sessions.find(tid);
+    if (host.sessions.end() == sit) {
+        return;
+    }
+    if (sit->clientPort != ev.srcPort) {
+        QByteArray errByteArray("\x00\x05\x00\x05", 4);
+        errByteArray.append("Unknown transfer ID");
+        errByteArray.append(static_cast<char>(0x00));
+        serverSend(host, ev.address, tid, ev.srcPort, errByteArray);
+        return;
+    }
+    if (0x05 == opCode) {
+        host.sessions.erase(sit);
+        return;
+    }
+    const quint16 block = static_cast<quint16>((static_cast<uchar>(ev.data.at(2)) << 8) |
+            static_cast<uchar>(ev.data.at(3)));
+    if ((0x04 != opCode) || (block != sit->block)) {
+        //duplicate ACKs are ignored to avoid the sorcerer's apprentice syndrome
+        return;
+    }
+    const int offset = (sit->block - 1) * BLOCK_SIZE;
+    if (BLOCK_SIZE > sit->file.size() - offset) {
+        //the last block has been acknowledged
+        host.sessions.erase(sit);
+        return;
+    }
+    ++sit->block;
+    sit->retransmits = 0;
+    sendBlock(host, ev.address, tid, sit.value());
+}
+
+void SimTransport::sendBlock(Host &host, quint32 address, quint16 tid,
+                             const Session &session)
+{
+    QByteArray dataByteArray;
+    dataByteArray.append(static_cast<char>(0x00));
+    dataByteArray.append(static_cast<char>(0x03));
+    dataByteArray.append(static_cast<char>(session.block >> 8));
+    dataByteArray.append(static_cast<char>(session.block & 0xff));
+    dataByteArray.append(session.file.mid((session.block - 1) * BLOCK_SIZE, BLOCK_SIZE));
+    serverSend(host, address, tid, session.clientPort, dataByteArray);
+
+    const Event ev = {Event::Retransmit, address, tid, session.block, QByteArray(), false};
+    schedule(_now + host.script.retransmitMs, ev);
+}
+
+void SimTransport::serverSend(Host &host, quint32 address, quint16 tid,
+                              quint16 clientPort, const QByteArray &data)
+{
+    const quint16 srcPort = host.script.replyFromListenPort ? _serverPort : tid;
+    const Event ev = {Event::ToSocket, address, srcPort, clientPort, data, false};
+    transmit(host, ev);
+}
+
+bool SimTransport::hasPending() const
+{
+    for (const auto &inbox: _inbox) {
+        if (!inbox.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "transport.h"
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QVector>
+#include <random>
+
+//deterministic in-process network with a virtual clock: each simulated host
+//runs a minimal TFTP server and applies its own latency, jitter, loss and
+//duplication, so the same seed and the same calls always give the same trace
+class SimTransport : public Transport
+{
+public:
+    enum { FIRST_LOCAL_PORT = 50000, FIRST_SERVER_TID = 40000 };
+    struct HostScript {
+        int latencyMs = 1;
+        //random extra delay per datagram, reorders datagrams when larger than their spacing
+        int jitterMs = 0;
+        double lossRate = 0;
+        double duplicateRate = 0;
+        //indices of datagrams exchanged with the host, in both directions, that are always lost
+        QSet<int> dropped;
+        int retransmitMs = 1000;
+        int maxRetransmits = 5;
+        //answer every datagram with an ICMP port unreachable
+        bool portClosed = false;
+        //reply from the listen port instead of a new TID, as some servers do
+        bool replyFromListenPort = false;
+        QHash<QString, QByteArray> files;
+    };
+    explicit SimTransport(quint32 seed = 1, quint16 serverPort = 69);
+    //must be called before the transport is opened
+    void addHost(const QString &address, const HostScript &script);
+    bool open(int numSockets) override;
+    void close() override;
+    int socketCount() const override { return _inbox.size(); }
+    quint16 localPort(int s) const override;
+    QString errorString(int) const override { return QString(); }
+    bool send(int s, const QByteArray &data, const QHostAddress &host,
+              quint16 port) override;
+    bool receive(int s, Datagram *datagram) override;
+    void wait(int timeoutMs) override;
+    qint64 now() const override { return _now; }
+    //advances the virtual clock, delivering everything due on the way
+    void advance(int ms);
+private:
+    enum { BLOCK_SIZE = 512 };
+    struct Event {
+        enum Type { ToHost, ToSocket, Retransmit };
+        Type type;
+        quint32 address;
+        quint16 srcPort;
+        quint16 dstPort;
+        QByteArray data;
+        bool unreachable;
+    };
+    struct Session {
+        quint16 clientPort = 0;
+        QByteArray file;
+        quint16 block = 0;
+        int retransmits = 0;
+    };
+    struct Host {
+        HostScript script;
+        int datagramCount = 0;
+        QHash<quint16, Session> sessions;//server TID is the key
+    };
+    double random();
+    void schedule(qint64 time, const Event &ev);
+    void transmit(Host &host, const Event &ev);
+    void deliver(const Event &ev);
+    void serverReceive(Host &host, const Event &ev);
+    void sendBlock(Host &host, quint32 address, quint16 tid, const Session &session);
+    void serverSend(Host &host, quint32 address, quint16 tid, quint16 clientPort,
+                    const QByteArray &data);
+    bool hasPending() const;
+
+    const quint16 _serverPort;
+    std::mt19937 _rng;
+    qint64 _now = 0;
+    quint64 _seq = 0;
+    quint16 _nextTid = FIRST_SERVER_TID;
+    QHash<quint32, Host> _hosts;
+    QVector<QQueue<Datagram> > _inbox;
+    //ordered by delivery time then by scheduling order
+    QMap<QPair<qint64, quint64>, Event> _events;
+};
@@ -0,0 +1,77 @@
+#include "statsmerge.h"
+#include "resultstore.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QMap>
+#include <QObject>
+#include <QTextStream>
+#include <QDebug>
+
+bool mergeStats(const QStringList &inputs, const QString &output, QString *error)
+{
+    QStringList files;
+    for (const auto &input: inputs) {
+        const QFileInfo info(input);
+        if (info.isDir()) {
+            //the results journals are preferred, they are written as the sweep goes
+            const QDir dir(input);
+            QStringList names = dir.entryList(QStringList() << "results*.bin", QDir::Files, QDir::Name);
+            if (names.isEmpty()) {
+                names = dir.entryList(QStringList() << "stats*.txt", QDir::Files, QDir::Name);
+            }
+            for (const auto &name: names) {
+                files.append(dir.filePath(name));
+            }
+        } else {
+            files.append(input);
+        }
+    }
+
+    //numeric address is the key so that the report is sorted like the sweep
+    QMap<quint32, QString> stats;
+    const QString absOutput = QFileInfo(output).absoluteFilePath();
+    for (const auto &fileName: files) {
+        if (QFileInfo(fileName).absoluteFilePath() == absOutput) {
+            continue;
+        }
+        if (fileName.endsWith(".bin")) {
+            if (!ResultStore::readDownloaded(fileName, &stats, error)) {
+                return false;
+            }
+            continue;
+        }
+        QFile ifile(fileName);
+        if (!ifile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            *error = QObject::tr("Cannot open ") + fileName;
+            return false;
+        }
+        QTextStream in(&ifile);
+        while (!in.atEnd()) {
+            const QString line = in.readLine();
+            const int sep = line.indexOf(": ");
+            bool isIPv4 = false;
+            const quint32 address = QHostAddress(line.left(sep)).toIPv4Address(&isIPv4);
+            if ((0 > sep) || !isIPv4) {
+                continue;
+            }
+            if (stats.contains(address)) {
+                qWarning() << "Address found in several shards" << line.left(sep);
+            }
+            stats.insert(address, line.mid(sep + 2));
+        }
+    }
+
+    QFile ofile(output);
+    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        *error = QObject::tr("Cannot open file for writing ") + output;
+        return false;
+    }
+    QTextStream stream(&ofile);
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+        stream << QHostAddress(it.key()).toString() << ": " << it.value() << endl;
+    }
+    qInfo() << "Merged" << files.size() << "files," << stats.size() << "addresses into" << output;
+    return true;
+}
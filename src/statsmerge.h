@@ -0,0 +1,8 @@
+#pragma once
+
+#include <QStringList>
+
+//combines the stats files or results journals written by the shards of a
+//sweep into one report sorted by address; directories are searched for
+//results*.bin files, then for stats*.txt files
+bool mergeStats(const QStringList &inputs, const QString &output, QString *error);
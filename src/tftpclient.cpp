@@ -1,4 +1,6 @@
 #include "tftpclient.h"
+#include "addressshard.h"
+#include "tracer.h"
 #include <QFile>
 #include <QDir>
 #include <QStandardPaths>
@@ -15,6 +17,12 @@
 #define SERVER_PORT "SERVER_PORT"
 #define READ_DELAY_MS "READ_DELAY_MS"
 #define NUM_WORKERS "NUM_WORKERS"
+#define TRACING "TRACING"
+#define NEG_CACHE_TTL "NEG_CACHE_TTL"
+#define ADAPTIVE_CONCURRENCY "ADAPTIVE_CONCURRENCY"
+#define INCREMENTAL "INCREMENTAL"
+#define CHANGE_REPORT "CHANGE_REPORT"
+#define NETASCII "NETASCII"
 
 TftpClient::TftpClient(QObject *parent) : QObject(parent)
 {
@@ -23,26 +31,65 @@ TftpClient::TftpClient(QObject *parent) : QObject(parent)
     setRunning(false);
 
     loadSettings();
-
-    _socketInfo.reset(new SocketInfo[_numWorkers]);
+    _dispatcher.setConcurrencyCallback([this](int window) {
+        setConcurrency(window);
+    });
     parseAddressList();
 }
 
 void TftpClient::startDownload()
 {
-    _stats.clear();
-    updateInfo();
     setRunning(true);
 
+    Tracer::instance().setEnabled(_tracing);
+    Tracer::instance().clear();
+
     std::thread th([this]() {
-        if (1 < _numWorkers) {
+        //filenames and requests are compiled once for all hosts
+        QString msg;
+        _plan.setMode(_netascii ? "netascii" : "octet");
+        if (!_plan.compile(_prefix, _files, _extension, &msg)) {
+            qCritical() << msg;
+            emit error(tr("Error"), msg);
+            setRunning(false);
+            return;
+        }
+        //results are streamed to disk as the sweep goes
+        if (!_results.open(outputFile("results", "bin"), _workingFolder, _plan.patterns())) {
+            emit error(tr("Error"), tr("Cannot open file for writing ") + outputFile("results", "bin"));
+            setRunning(false);
+            return;
+        }
+        updateInfo(true);
+        _negCache.setTtl(_negativeCacheTtl);
+        _negCache.load(negativeCacheFile());
+        _index.setEnabled(_incremental);
+        _index.load(outputFile("index", "dat"));
+        _skippedHosts = 0;
+        //when adaptive, the workers only bound the limit set by the dispatcher
+        _poolSize = _adaptiveConcurrency ? qMax(_numWorkers, static_cast<int>(MAX_ADAPTIVE_WORKERS)) :
+                                           _numWorkers;
+        _dispatcher.setSocketCount(_poolSize);
+        _dispatcher.setConcurrency(_numWorkers, _poolSize, _adaptiveConcurrency);
+        _dispatcher.setNetascii(_netascii);
+        setConcurrency(0);
+        if (!_dispatcher.start(static_cast<quint16>(_serverPort), _readDelayMs)) {
+            _results.close();
+            emit error(tr("Error"), tr("Cannot bind local sockets"));
+            setRunning(false);
+            return;
+        }
+        if (_adaptiveConcurrency) {
+            setConcurrency(_dispatcher.concurrency());
+        }
+        if (1 < _poolSize) {
             _threadPool.init();
-            _threadPool.resize(_numWorkers);
+            _threadPool.resize(_poolSize);
         }
         bool stopped = false;
         setAddrIndex(0);
         for (const auto &ip: _singleAddresses) {
-            downloadFileList(ip);
+            downloadFileList(QHostAddress(ip).toIPv4Address());
             if (!_running) {
                 qWarning() << "Stopped by user";
                 stopped = true;
@@ -52,8 +99,7 @@ void TftpClient::startDownload()
         if (!stopped) {
             for (const auto &pairIp: _pairAddresses) {
                 for (quint32 ipNum = pairIp.first; ipNum <= pairIp.second; ++ipNum) {
-                    QHostAddress hostAddr(ipNum);
-                    downloadFileList(hostAddr.toString());
+                    downloadFileList(ipNum);
                     if (!_running) {
                         qWarning() << "Stopped by user";
                         stopped = true;
@@ -67,7 +113,22 @@ void TftpClient::startDownload()
         }
         //wait until all threads finish
         _threadPool.stop(_running);
+        _dispatcher.stop();
+        if (0 < _skippedHosts) {
+            qInfo() << "Skipped" << _skippedHosts.load() << "hosts found in the negative cache";
+        }
+        _negCache.save(negativeCacheFile());
+        _index.save(outputFile("index", "dat"));
         dumpStats();
+        if (_incremental) {
+            dumpChanges();
+        }
+        if (_tracing) {
+            const QString traceFile = outputFile("trace", "json");
+            if (Tracer::instance().dump(traceFile)) {
+                emit info(tr("Timeline written to ") + traceFile);
+            }
+        }
         setRunning(false);
     });
     th.detach();
@@ -76,6 +137,7 @@ void TftpClient::startDownload()
 void TftpClient::stopDownload()
 {
     setRunning(false);
+    _dispatcher.cancel();
 }
 
 QString TftpClient::toLocalFile(const QUrl &url)
@@ -89,158 +151,83 @@ QString TftpClient::toLocalFile(const QUrl &url)
     return out;
 }
 
-bool TftpClient::get(int i, const QString &serverAddress,
-                     const QString &filename)
+bool TftpClient::get(HostProbe &probe, int entry, const QString &filename,
+                     const QByteArray &reqPacket)
 {
-    if ((0 > i) || (_numWorkers <= i)) {
-        qCritical() << "Invalid index";
-        return false;
-    }
-
-    SocketInfo *sockInfo = _socketInfo.get() + i;
-    auto &socket = sockInfo->socket;
-
-    if (socket.isNull()) {
-        //sockets must be created in the calling thread
-        socket.reset(new QUdpSocket());
-        bool rc = socket->bind();
-        if (!rc) {
-            qCritical() << "Cannot bind socket" << i << ":"
-                        << socket->errorString();
-            return false;
-        }
-    }
-
+    const QString &serverAddress = probe.address;
+    QString lastError;
     if (serverAddress.isEmpty()) {
-        sockInfo->lastError = tr("Server address cannot be empty");
-        qCritical() << sockInfo->lastError;
+        lastError = tr("Server address cannot be empty");
+        qCritical() << lastError;
         return false;
     }
     if (filename.isEmpty()) {
-        sockInfo->lastError = tr("Filename cannot be empty");
-        qCritical() << sockInfo->lastError;
+        lastError = tr("Filename cannot be empty");
+        qCritical() << lastError;
         return false;
     }
 
-    // MAKE A LOCAL COPY OF THE REMOTE HOST ADDRESS AND PORT NUMBER
-    const QHostAddress hostAddress(serverAddress);
-
-    // CLEAN OUT ANY INCOMING PACKETS
-    if (QAbstractSocket::BoundState != socket->state()) {
-        bool rc = socket->bind();
-        if (!rc) {
-            qCritical() << "Cannot bind socket" << i << ":"
-                        << socket->errorString();
-            return false;
+    //the dispatcher routes the transfer over one of its shared sockets
+    const qint64 transferStart = Tracer::nowUs();
+    const Dispatcher::Result result = _dispatcher.get(serverAddress, reqPacket);
+    Tracer::instance().complete("transfer", transferStart, probe.ipNum);
+    ResultStore::Record record = {probe.ipNum, static_cast<quint32>(entry),
+                                  ResultStore::ServerError, 0,
+                                  static_cast<quint32>((Tracer::nowUs() - transferStart) / 1000)};
+    switch (result.status) {
+    case Dispatcher::Success:
+        probe.responded = true;
+        break;
+    case Dispatcher::Timeout:
+        probe.silent = true;
+        record.status = ResultStore::Timeout;
+        break;
+    case Dispatcher::Unreachable:
+        probe.silent = true;
+        probe.unreachable = true;
+        record.status = ResultStore::Unreachable;
+        break;
+    case Dispatcher::Error:
+        probe.responded = true;
+        if (FILE_NOT_FOUND == result.errorCode) {
+            _negCache.addFile(probe.ipNum, filename);
+            record.status = ResultStore::NotFound;
         }
+        qCritical() << result.error;
+        break;
+    case Dispatcher::Cancelled:
+        probe.cancelled = true;
+        record.status = ResultStore::Cancelled;
+        break;
+    case Dispatcher::SendFailed:
+        //says nothing about the host
+        record.status = ResultStore::SendFailed;
+        qCritical() << result.error;
+        break;
     }
-    while (socket->hasPendingDatagrams()){
-        QByteArray byteArray;
-        byteArray.resize(static_cast<int>(socket->pendingDatagramSize()));
-        socket->readDatagram(byteArray.data(), byteArray.length());
-    }
-
-    // CREATE REQUEST PACKET AND SEND TO HOST
-    // WAIT UNTIL MESSAGE HAS BEEN SENT, QUIT IF TIMEOUT IS REACHED
-    QByteArray reqPacket=getFilePacket(filename);
-    if (socket->writeDatagram(reqPacket, hostAddress,
-                                       static_cast<quint16>(_serverPort)) !=
-            reqPacket.length()) {
-        sockInfo->lastError = QString("Cannot send packet to host : %1").arg(socket->errorString());
-        qCritical() << sockInfo->lastError;
+    if (Dispatcher::Success != result.status) {
+        _results.append(record);
         return false;
     }
-
-    // CREATE PACKET COUNTERS TO KEEP TRACK OF MESSAGES
-    unsigned short incomingPacketNumber = 1;
-    unsigned short outgoingPacketNumber = 1;
-
-    // NOW WAIT HERE FOR INCOMING DATA
-    bool messageCompleteFlag = false;
-    QByteArray requestedFile;
-    while (!messageCompleteFlag){
-        // WAIT FOR AN INCOMING PACKET
-        if (socket->hasPendingDatagrams() || socket->waitForReadyRead(_readDelayMs)) {
-            // ITERATE HERE AS LONG AS THERE IS ATLEAST A
-            // PACKET HEADER'S WORTH OF DATA TO READ
-            QByteArray incomingDatagram;
-            incomingDatagram.resize(static_cast<int>(socket->pendingDatagramSize()));
-            socket->readDatagram(incomingDatagram.data(), incomingDatagram.length());
-
-            // MAKE SURE FIRST BYTE IS 0
-            char *buffer=incomingDatagram.data();
-            char zeroByte=buffer[0];
-            if (zeroByte != 0x00) {
-                sockInfo->lastError = QString("Incoming packet has invalid first byte (%1).").arg(static_cast<int>(zeroByte));
-                qCritical() << sockInfo->lastError;
-                return false;
-            }
-
-            // READ UNSIGNED SHORT PACKET NUMBER USING LITTLE ENDIAN FORMAT
-            // FOR THE INCOMING UNSIGNED SHORT VALUE BUT BIG ENDIAN FOR THE
-            // INCOMING DATA PACKET
-            unsigned short incomingMessageCounter;
-            char *const inPtr = reinterpret_cast<char*>(&incomingMessageCounter);
-            inPtr[1] = buffer[2];
-            inPtr[0] = buffer[3];
-
-            // CHECK INCOMING MESSAGE ID NUMBER AND MAKE SURE IT MATCHES
-            // WHAT WE ARE EXPECTING, OTHERWISE WE'VE LOST OR GAINED A PACKET
-            if (incomingMessageCounter == incomingPacketNumber){
-                incomingPacketNumber++;
-            } else {
-                sockInfo->lastError = QString("Error on incoming packet number %1 vs expected %2").arg(incomingMessageCounter).arg(incomingPacketNumber);
-                qCritical() << sockInfo->lastError;
-                return false;
-            }
-
-            // COPY THE INCOMING FILE DATA
-            QByteArray incomingByteArray(&buffer[4], incomingDatagram.length()-4);
-
-            // SEE IF WE RECEIVED A COMPLETE 512 BYTES AND IF SO,
-            // THEN THERE IS MORE INFORMATION ON THE WAY
-            // OTHERWISE, WE'VE REACHED THE END OF THE RECEIVING FILE
-            if (incomingByteArray.length() < MAX_PACKET_SIZE) {
-                messageCompleteFlag=true;
-            }
-
-            // APPEND THE INCOMING DATA TO OUR COMPLETE FILE
-            requestedFile.append(incomingByteArray);
-
-            // CHECK THE OPCODE FOR ANY ERROR CONDITIONS
-            char opCode=buffer[1];
-            if (opCode != 0x03) { /* ack packet should have code 3 (data) and should be ack+1 the packet we just sent */
-                sockInfo->lastError = QString("Incoming packet returned invalid operation code (%1).").arg(static_cast<int>(opCode));
-                qCritical() << sockInfo->lastError;
-                return false;
-            } else {
-                // SEND PACKET ACKNOWLEDGEMENT BACK TO HOST REFLECTING THE INCOMING PACKET NUMBER
-                QByteArray ackByteArray;
-                ackByteArray.append(static_cast<char>(0x00));
-                ackByteArray.append(static_cast<char>(0x04));
-                ackByteArray.append(inPtr[1]);
-                ackByteArray.append(inPtr[0]);
-
-                // SEND THE PACKET AND MAKE SURE IT GETS SENT
-                if (socket->writeDatagram(ackByteArray, hostAddress,
-                                                   static_cast<quint16>(_serverPort)) != ackByteArray.length()) {
-                    sockInfo->lastError = QString("Cannot send ack packet to host : %1").arg(socket->errorString());
-                    qCritical() << sockInfo->lastError;
-                    return false;
-                }
-
-                // NOW THAT WE'VE SENT AN ACK SIGNAL, INCREMENT SENT MESSAGE COUNTER
-                outgoingPacketNumber++;
-            }
-        } else {
-            //sockInfo->lastError = QString("No message received from host : %1").arg(socket.errorString());
-            //qCritical() << sockInfo->lastError;
-            return false;
-        }
+    const QByteArray &requestedFile = result.content;
+    QByteArray hash;
+    const ContentIndex::Change change = _index.enabled() ?
+                _index.compare(probe.ipNum, filename, requestedFile, &hash) : ContentIndex::Added;
+    record.size = static_cast<quint32>(requestedFile.size());
+    if ((ContentIndex::Unchanged == change) &&
+            QFile::exists(_workingFolder + "/" + serverAddress + "/" + filename)) {
+        //same content as the previous sweep, the file is kept as it is
+        record.status = ResultStore::Unchanged;
+        _results.append(record);
+        updateInfo();
+        return true;
     }
 
     //only one thread accesses the harddisk
+    const qint64 lockStart = Tracer::nowUs();
     QMutexLocker locker(&_statsMutex);
+    Tracer::instance().complete("lock wait", lockStart);
+    const qint64 writeStart = Tracer::nowUs();
 
     //must create folder only once, after the file is downloaded
     //make sure that the destination folder exists
@@ -249,44 +236,43 @@ bool TftpClient::get(int i, const QString &serverAddress,
 
     //open file for writing
     QFile ofile(filePath + "/" + filename);
-    if (ofile.exists()) {
-        sockInfo->lastError = tr("File ") + ofile.fileName() + tr(" will be overwritten");
-        qWarning() << sockInfo->lastError;
+    if (ofile.exists() && !_index.enabled()) {
+        lastError = tr("File ") + ofile.fileName() + tr(" will be overwritten");
+        qWarning() << lastError;
     }
     if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         QDir().rmdir(filePath);
-        sockInfo->lastError = tr("Cannot open file for writing ") + filename;
-        qCritical() << sockInfo->lastError;
+        lastError = tr("Cannot open file for writing ") + filename;
+        qCritical() << lastError;
+        record.status = ResultStore::WriteFailed;
+        _results.append(record);
         return false;
     }
     qint64 len = ofile.write(requestedFile);
     if (len != requestedFile.size()) {
         ofile.remove();
         qCritical() << "Cannot write received content to file" << len << requestedFile.size();
+        record.status = ResultStore::WriteFailed;
+        _results.append(record);
         return false;
     }
+    ofile.close();
+    //a file that could not be written keeps its previous hash
+    if (_index.enabled()) {
+        _index.commit(probe.ipNum, filename, hash, change);
+    }
+    Tracer::instance().complete("disk write", writeStart);
     const QString msg = tr("Downloaded ") + ofile.fileName();
     qInfo() << msg;
     emit info(msg);
 
-    _stats[serverAddress] = ofile.fileName();
+    record.status = ResultStore::Downloaded;
+    _results.append(record);
     updateInfo();
 
     return true;
 }
 
-QByteArray TftpClient::getFilePacket(const QString &filename)
-{
-    QByteArray byteArray(filename.toLatin1());
-    byteArray.prepend(static_cast<char>(0x01)); // OPCODE
-    byteArray.prepend(static_cast<char>(0x00));
-    byteArray.append(static_cast<char>(0x00));
-    byteArray.append(QString("octet").toLatin1()); // MODE
-    byteArray.append(static_cast<char>(0x00));
-
-    return(byteArray);
-}
-
 QByteArray TftpClient::putFilePacket(const QString &filename)
 {
     QByteArray byteArray;
@@ -300,6 +286,40 @@ QByteArray TftpClient::putFilePacket(const QString &filename)
     return(byteArray);
 }
 
+bool TftpClient::setShard(int index, int count)
+{
+    if ((1 > count) || (0 > index) || (count <= index)) {
+        qCritical() << "Invalid shard" << index << count;
+        return false;
+    }
+    _shardIndex = index;
+    _shardCount = count;
+    return true;
+}
+
+void TftpClient::applyShard()
+{
+    if (1 >= _shardCount) {
+        return;
+    }
+    //each shard takes a contiguous slice of the addresses, in file order
+    const quint64 count = AddressShard::apply(_shardIndex, _shardCount, &_singleAddresses,
+                                              &_pairAddresses);
+    setAddrCount(static_cast<int>(count));
+    qInfo() << "Shard" << (_shardIndex + 1) << "of" << _shardCount << ":"
+            << _addrCount << "addresses";
+}
+
+QString TftpClient::outputFile(const QString &baseName, const QString &extension) const
+{
+    //shards may share the working folder
+    QString name = _workingFolder + "/" + baseName;
+    if (1 < _shardCount) {
+        name += QString("-%1of%2").arg(_shardIndex + 1).arg(_shardCount);
+    }
+    return name + "." + extension;
+}
+
 bool TftpClient::parseAddressList()
 {
     _singleAddresses.clear();
@@ -315,6 +335,7 @@ bool TftpClient::parseAddressList()
     if (QAbstractSocket::IPv4Protocol == hostAddr.protocol()) {
         _singleAddresses.append(_hosts.trimmed());
         setAddrCount(1);
+        applyShard();
         return true;
     }
 
@@ -351,51 +372,67 @@ bool TftpClient::parseAddressList()
             }
         }
     }
+    emit addrCountChanged();
+    applyShard();
     qDebug() << "Single addresses" << _singleAddresses.size();
     qDebug() << "Address ranges" << _pairAddresses.size();
-    emit addrCountChanged();
     return true;
 }
 
-void TftpClient::downloadFileList(const QString &address)
+void TftpClient::downloadFileList(quint32 ipNum)
 {
+    const QString address = QHostAddress(ipNum).toString();
     setCurrentAddress(address);
     setCurrentFilename("");
-    _found = false;
 
-    if (!QFile::exists(_files)) {
-        //assume that this is the filename to be downloaded
-        const QString file = generateFilename(_files);
-        get(0, address, file);
+    if (_negCache.containsHost(ipNum)) {
+        //did not answer during a recent sweep
+        ++_skippedHosts;
+        setAddrIndex(_addrIndex + 1);
         return;
     }
-
-    //got list of files
-    QFile ifile(_files);
-    if (!ifile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        const QString msg = tr("Cannot open ") + ifile.fileName();
-        qCritical() << msg;
-        emit error(tr("Error"), msg);
-        return;
-    }
-    QTextStream in(&ifile);
-    while (!in.atEnd()) {
-        const QString file = generateFilename(in.readLine().trimmed());
+    //the workers may still use the probe after this call returns
+    auto probe = std::make_shared<HostProbe>();
+    probe->address = address;
+    probe->ipNum = ipNum;
+
+    //buffers reused for the templated entries of the plan, the workers
+    //render again into their own buffers so that these are never shared
+    QString file;
+    QByteArray packet;
+    for (int n = 0; n < _plan.size(); ++n) {
+        _plan.render(n, ipNum, &file, &packet);
+        if (_negCache.containsFile(ipNum, file)) {
+            continue;
+        }
         setCurrentFilename(file);
-        if (1 < _numWorkers) {
-            auto f = _threadPool.push([this, address, file](int i) {
-                _found = get(i, address, file);
+        ++probe->pending;
+        if (1 < _poolSize) {
+            const qint64 dispatchStart = Tracer::nowUs();
+            auto f = _threadPool.push([this, probe, n, dispatchStart](int) {
+                Tracer::instance().complete("queued", dispatchStart);
+                thread_local QString workerFile;
+                thread_local QByteArray workerPacket;
+                _plan.render(n, probe->ipNum, &workerFile, &workerPacket);
+                if (get(*probe, n, workerFile, workerPacket)) {
+                    probe->found = true;
+                }
+                releaseProbe(*probe);
             });
 
-            while (0 == _threadPool.n_idle() && !_found) {
+            while (0 == _threadPool.n_idle() && !probe->found) {
                 //sleep until some threads become available
                 std::this_thread::sleep_for (std::chrono::milliseconds(100));
             }
+            Tracer::instance().complete("dispatch", dispatchStart);
         } else {
-            _found = get(0, address, file);
+            probe->found = get(*probe, n, file, packet);
+            releaseProbe(*probe);
         }
 
-        if (_found) {
+        //with a pool the flag is only seen a few requests later, the
+        //dispatcher fails the queued requests to the host meanwhile
+        if (probe->found || probe->unreachable) {
             break;
         }
 
@@ -404,36 +441,72 @@ void TftpClient::downloadFileList(const QString &address)
             break;
         }
     }
+    releaseProbe(*probe);
 
     setAddrIndex(_addrIndex + 1);
 }
 
+void TftpClient::releaseProbe(HostProbe &probe)
+{
+    if (0 != --probe.pending) {
+        return;
+    }
+    //a host is dead only if nothing came back and nothing was cancelled
+    if (probe.silent && !probe.responded && !probe.cancelled) {
+        _negCache.addHost(probe.ipNum);
+    }
+}
+
 void TftpClient::dumpStats()
 {
-    if (_stats.isEmpty()) {
+    const QString resultsFile = outputFile("results", "bin");
+    _results.close();
+    if (0 == _results.downloaded()) {
         emit info(tr("No files have been downloaded"));
         return;
     }
-    QFile ofile(_workingFolder + "/stats.txt");
-    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        const QString msg = tr("Cannot open file for writing ") + ofile.fileName();
+    //stats.txt is generated from the results journal
+    QString msg;
+    if (!ResultStore::exportStats(QStringList() << resultsFile, outputFile("stats", "txt"), &msg)) {
         qCritical() << msg;
         emit error(tr("Error"), msg);
         return;
     }
-    QTextStream stream(&ofile);
-    for (const auto &addr: _stats.keys()) {
-        stream << addr << ": " << _stats[addr] << endl;
+    updateInfo(true);
+}
+
+void TftpClient::dumpChanges()
+{
+    const int changes = _index.changeCount();
+    emit info(QString::number(changes) + tr(" files have been added or modified"));
+    if (!_changeReport) {
+        return;
     }
-    updateInfo();
+    QString msg;
+    const QString changesFile = outputFile("changes", "txt");
+    if (!_index.writeReport(changesFile, _workingFolder, &msg)) {
+        qCritical() << msg;
+        emit error(tr("Error"), msg);
+        return;
+    }
+    emit info(tr("Changes written to ") + changesFile);
 }
 
-void TftpClient::updateInfo()
+void TftpClient::updateInfo(bool force)
 {
+    const qint64 now = Tracer::nowUs() / 1000;
+    qint64 last = _lastInfoMs;
+    if (force) {
+        _lastInfoMs = now;
+    } else if ((INFO_INTERVAL_MS > now - last) || !_lastInfoMs.compare_exchange_strong(last, now)) {
+        //shown recently or by another worker right now
+        return;
+    }
+    const int downloaded = _results.downloaded();
     QString msg;
-    if (1 < _stats.size()) {
-        msg = QString::number(_stats.size()) + tr(" files have been downloaded");
-    } else if (1 == _stats.size()) {
+    if (1 < downloaded) {
+        msg = QString::number(downloaded) + tr(" files have been downloaded");
+    } else if (1 == downloaded) {
         msg = tr("1 file has been downloaded");
     } else {
         msg = tr("No files have been downloaded");
@@ -453,6 +526,12 @@ void TftpClient::loadSettings()
 
     setServerPort(settings.value(SERVER_PORT, DEFAULT_PORT).toInt());
     setReadDelayMs(settings.value(READ_DELAY_MS, DEFAULT_READ_DELAY_MS).toInt());
+    setTracing(settings.value(TRACING, false).toBool());
+    setNegativeCacheTtl(settings.value(NEG_CACHE_TTL, 0).toInt());
+    setAdaptiveConcurrency(settings.value(ADAPTIVE_CONCURRENCY, false).toBool());
+    setIncremental(settings.value(INCREMENTAL, false).toBool());
+    setChangeReport(settings.value(CHANGE_REPORT, false).toBool());
+    setNetascii(settings.value(NETASCII, false).toBool());
 
     //default value
     _numWorkers = static_cast<int>(std::thread::hardware_concurrency());
@@ -475,13 +554,15 @@ void TftpClient::saveSettings()
     settings.setValue(SERVER_PORT, _serverPort);
     settings.setValue(READ_DELAY_MS, _readDelayMs);
     settings.setValue(NUM_WORKERS, _numWorkers);
+    settings.setValue(TRACING, _tracing);
+    settings.setValue(NEG_CACHE_TTL, _negativeCacheTtl);
+    settings.setValue(ADAPTIVE_CONCURRENCY, _adaptiveConcurrency);
+    settings.setValue(INCREMENTAL, _incremental);
+    settings.setValue(CHANGE_REPORT, _changeReport);
+    settings.setValue(NETASCII, _netascii);
 }
 
-QString TftpClient::generateFilename(const QString &suffix)
+QString TftpClient::negativeCacheFile() const
 {
-    QString fn = _prefix + suffix;
-    if (!_extension.isEmpty()) {
-        fn += "." + _extension;
-    }
-    return fn;
+    return outputFile("negative-cache", "dat");
 }
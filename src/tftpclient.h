@@ -2,8 +2,13 @@
 
 #include "qmlhelpers.h"
 #include "ctpl_stl.h"
-#include <QUdpSocket>
+#include "dispatcher.h"
+#include "requestplan.h"
+#include "negativecache.h"
+#include "contentindex.h"
+#include "resultstore.h"
 #include <atomic>
+#include <memory>
 #include <QMutex>
 
 class TftpClient : public QObject
@@ -19,16 +24,26 @@ class TftpClient : public QObject
     QML_READABLE_PROPERTY(int, addrIndex, setAddrIndex, 0)
     QML_READABLE_PROPERTY(QString, currentAddress, setCurrentAddress, "")
     QML_READABLE_PROPERTY(QString, currentFilename, setCurrentFilename, "")
+    //transfers allowed in flight by the adaptive controller, 0 when disabled
+    QML_READABLE_PROPERTY(int, concurrency, setConcurrency, 0)
     //settings props
     QML_WRITABLE_PROPERTY(int, serverPort, setServerPort, DEFAULT_PORT)
     QML_WRITABLE_PROPERTY(int, readDelayMs, setReadDelayMs, DEFAULT_READ_DELAY_MS)
     QML_WRITABLE_PROPERTY(int, numWorkers, setNumWorkers, DEFAULT_NUM_WORKERS)
+    QML_WRITABLE_PROPERTY(bool, adaptiveConcurrency, setAdaptiveConcurrency, false)
+    QML_WRITABLE_PROPERTY(bool, tracing, setTracing, false)
+    QML_WRITABLE_PROPERTY(int, negativeCacheTtl, setNegativeCacheTtl, 0)
+    QML_WRITABLE_PROPERTY(bool, incremental, setIncremental, false)
+    QML_WRITABLE_PROPERTY(bool, changeReport, setChangeReport, false)
+    QML_WRITABLE_PROPERTY(bool, netascii, setNetascii, false)
 public:
     explicit TftpClient(QObject *parent = nullptr);
     Q_INVOKABLE void startDownload();
     Q_INVOKABLE void stopDownload();
     Q_INVOKABLE QString toLocalFile(const QUrl &url);
     Q_INVOKABLE bool parseAddressList();
+    //this process only sweeps the slice index (zero based) out of count
+    bool setShard(int index, int count);
     bool running() const { return _running; }
     void setRunning(bool val) {
         if (_running != val) {
@@ -42,27 +57,49 @@ signals:
     void info(const QString &msg);
     void runningChanged();
 private:
-    enum { DEFAULT_PORT = 69, MAX_PACKET_SIZE = 512, DEFAULT_READ_DELAY_MS = 1000,
-           DEFAULT_NUM_WORKERS = 4 };
-    void downloadFileList(const QString &address);
+    enum { DEFAULT_PORT = 69, DEFAULT_READ_DELAY_MS = 1000, DEFAULT_NUM_WORKERS = 4,
+           MAX_ADAPTIVE_WORKERS = 128, FILE_NOT_FOUND = 1, INFO_INTERVAL_MS = 250 };
+    //outcome of the requests sent to one host, shared with the workers
+    struct HostProbe {
+        QString address;
+        quint32 ipNum = 0;
+        //one reference is held by downloadFileList() itself
+        std::atomic<int> pending{1};
+        //a file was downloaded, the other suffixes are not requested
+        std::atomic<bool> found{false};
+        std::atomic<bool> responded{false};
+        std::atomic<bool> silent{false};
+        std::atomic<bool> unreachable{false};
+        std::atomic<bool> cancelled{false};
+    };
+    void downloadFileList(quint32 ipNum);
+    void releaseProbe(HostProbe &probe);
     void dumpStats();
-    bool get(int i, const QString &serverAddress, const QString &filename);
-    void updateInfo();
-    QByteArray getFilePacket(const QString &filename);
+    void dumpChanges();
+    bool get(HostProbe &probe, int entry, const QString &filename,
+             const QByteArray &reqPacket);
+    //the workers call it for every file, the count is shown a few times per
+    //second at most unless forced
+    void updateInfo(bool force = false);
     QByteArray putFilePacket(const QString &filename);
     void loadSettings();
-    QString generateFilename(const QString &suffix);
+    QString negativeCacheFile() const;
+    void applyShard();
+    QString outputFile(const QString &baseName, const QString &extension) const;
 
-    struct SocketInfo {
-        QScopedPointer<QUdpSocket> socket;
-        QString lastError;
-    };
-    QScopedPointer<SocketInfo> _socketInfo;
-    QMap<QString, QString> _stats;//address is the key
+    Dispatcher _dispatcher;
+    RequestPlan _plan;
+    NegativeCache _negCache;
+    ContentIndex _index;
+    std::atomic<int> _skippedHosts;
+    int _poolSize = 1;
+    ResultStore _results;
     QMutex _statsMutex;
     std::atomic<bool> _running;
-    std::atomic<bool> _found;
+    std::atomic<qint64> _lastInfoMs{0};
     QVector<QString> _singleAddresses;
     QVector<QPair<quint32, quint32> > _pairAddresses;
+    int _shardIndex = 0;
+    int _shardCount = 1;
     ctpl::thread_pool _threadPool;
 };
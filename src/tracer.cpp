@@ -0,0 +1,125 @@
+#include "tracer.h"
+#include <QFile>
+#include <QHostAddress>
+#include <QTextStream>
+#include <QDebug>
+#include <chrono>
+
+Tracer::Tracer()
+{
+    _enabled = false;
+    _generation = 0;
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+qint64 Tracer::nowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::complete(const char *name, qint64 startUs, quint32 address)
+{
+    if (!enabled()) {
+        return;
+    }
+    const Event ev = {name, startUs, nowUs() - startUs, address, 'X'};
+    record(ev);
+}
+
+void Tracer::instant(const char *name, quint32 address)
+{
+    if (!enabled()) {
+        return;
+    }
+    const Event ev = {name, nowUs(), 0, address, 'i'};
+    record(ev);
+}
+
+void Tracer::counter(const char *name, qint64 value)
+{
+    if (!enabled()) {
+        return;
+    }
+    const Event ev = {name, nowUs(), value, 0, 'C'};
+    record(ev);
+}
+
+Tracer::Ring* Tracer::ring()
+{
+    //rings outlive their threads, the pool threads are gone by dump time
+    thread_local Ring *threadRing = nullptr;
+    thread_local int threadGeneration = -1;
+    const int generation = _generation.load(std::memory_order_acquire);
+    if ((nullptr == threadRing) || (generation != threadGeneration)) {
+        QMutexLocker locker(&_ringsMutex);
+        _rings.emplace_back(new Ring());
+        threadRing = _rings.back().get();
+        threadRing->tid = static_cast<int>(_rings.size());
+        threadGeneration = generation;
+    }
+    return threadRing;
+}
+
+void Tracer::record(const Event &ev)
+{
+    //single writer per ring, grows with use then the oldest events are overwritten
+    Ring *r = ring();
+    if (static_cast<size_t>(RING_CAPACITY) > r->events.size()) {
+        r->events.push_back(ev);
+    } else {
+        r->events[r->count % RING_CAPACITY] = ev;
+    }
+    ++r->count;
+}
+
+void Tracer::clear()
+{
+    //each sweep runs on new threads, the rings of the previous ones are
+    //freed instead of piling up over a long session
+    QMutexLocker locker(&_ringsMutex);
+    _rings.clear();
+    _generation.fetch_add(1, std::memory_order_release);
+}
+
+bool Tracer::dump(const QString &fileName)
+{
+    QFile ofile(fileName);
+    if (!ofile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical() << "Cannot open file for writing" << fileName;
+        return false;
+    }
+    QTextStream stream(&ofile);
+    stream << "{\"traceEvents\":[";
+    bool first = true;
+    QMutexLocker locker(&_ringsMutex);
+    for (const auto &r: _rings) {
+        const quint64 begin = (RING_CAPACITY < r->count) ? (r->count - RING_CAPACITY) : 0;
+        for (quint64 n = begin; n < r->count; ++n) {
+            const Event &ev = r->events[n % RING_CAPACITY];
+            stream << (first ? "\n" : ",\n");
+            first = false;
+            stream << "{\"name\":\"" << ev.name << "\",\"ph\":\"" << ev.phase
+                   << "\",\"ts\":" << ev.ts << ",\"pid\":1,\"tid\":" << r->tid;
+            if ('X' == ev.phase) {
+                stream << ",\"dur\":" << ev.dur;
+            } else if ('C' == ev.phase) {
+                stream << ",\"args\":{\"value\":" << ev.dur << "}";
+            } else {
+                stream << ",\"s\":\"t\"";
+            }
+            if (0 != ev.address) {
+                stream << ",\"args\":{\"address\":\"" << QHostAddress(ev.address).toString() << "\"}";
+            }
+            stream << "}";
+        }
+    }
+    stream << "\n]}\n";
+    stream.flush();
+    return QFile::NoError == ofile.error();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//records timeline events into per thread ring buffers and dumps them in the
+//Chrome trace format (chrome://tracing, ui.perfetto.dev)
+class Tracer
+{
+public:
+    //events kept per thread, 128 KiB at most
+    enum { RING_CAPACITY = 1 << 12 };
+    static Tracer& instance();
+    bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool val) { _enabled = val; }
+    static qint64 nowUs();
+    //span from startUs until now
+    void complete(const char *name, qint64 startUs, quint32 address = 0);
+    void instant(const char *name, quint32 address = 0);
+    //value over time, drawn as a graph
+    void counter(const char *name, qint64 value);
+    //frees the rings of all threads, must not run while events are recorded
+    void clear();
+    bool dump(const QString &fileName);
+private:
+    struct Event {
+        const char *name;
+        qint64 ts;
+        //value of a counter
+        qint64 dur;
+        quint32 address;
+        char phase;
+    };
+    struct Ring {
+        int tid = 0;
+        quint64 count = 0;
+        std::vector<Event> events;
+    };
+    Tracer();
+    Ring* ring();
+    void record(const Event &ev);
+
+    std::atomic<bool> _enabled;
+    //bumped by clear(), threads then drop their freed ring
+    std::atomic<int> _generation;
+    QMutex _ringsMutex;
+    std::vector<std::unique_ptr<Ring> > _rings;
+};
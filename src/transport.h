@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+
+//datagram transport used by the dispatcher, all methods are called from the
+//dispatcher thread only
+class Transport
+{
+public:
+    struct Datagram {
+        QByteArray data;
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        //no data, an ICMP error reported that sender:senderPort cannot be reached
+        bool unreachable = false;
+    };
+    virtual ~Transport() {}
+    virtual bool open(int numSockets) = 0;
+    virtual void close() = 0;
+    virtual int socketCount() const = 0;
+    virtual quint16 localPort(int s) const = 0;
+    virtual QString errorString(int s) const = 0;
+    //may only queue the datagram until the next flush
+    virtual bool send(int s, const QByteArray &data, const QHostAddress &host,
+                      quint16 port) = 0;
+    //hands the queued datagrams to the network
+    virtual void flush() {}
+    //non blocking, returns false when no datagram is pending on the socket
+    virtual bool receive(int s, Datagram *datagram) = 0;
+    //blocks until a datagram is pending on any socket or the timeout expires
+    virtual void wait(int timeoutMs) = 0;
+    //monotonic time in milliseconds
+    virtual qint64 now() const = 0;
+};
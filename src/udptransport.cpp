@@ -0,0 +1,171 @@
+#include "udptransport.h"
+#include <QDebug>
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include <cstring>
+#endif
+
+#ifdef Q_OS_LINUX
+//destination, host or port unreachable
+static bool isUnreachable(const sock_extended_err *err)
+{
+    if (SO_EE_ORIGIN_ICMP == err->ee_origin) {
+        return (ICMP_DEST_UNREACH == err->ee_type) &&
+                ((ICMP_NET_UNREACH == err->ee_code) || (ICMP_HOST_UNREACH == err->ee_code) ||
+                 (ICMP_PROT_UNREACH == err->ee_code) || (ICMP_PORT_UNREACH == err->ee_code) ||
+                 (ICMP_NET_UNKNOWN == err->ee_code) || (ICMP_HOST_UNKNOWN == err->ee_code));
+    }
+    return (ICMP6_DST_UNREACH == err->ee_type) &&
+            ((ICMP6_DST_UNREACH_NOROUTE == err->ee_code) || (ICMP6_DST_UNREACH_ADDR == err->ee_code) ||
+             (ICMP6_DST_UNREACH_NOPORT == err->ee_code));
+}
+#endif
+
+UdpTransport::~UdpTransport()
+{
+    close();
+}
+
+bool UdpTransport::open(int numSockets)
+{
+    close();
+    //sockets must be created in the calling thread
+    for (int s = 0; s < numSockets; ++s) {
+        QUdpSocket *socket = new QUdpSocket();
+        if (!socket->bind()) {
+            qCritical() << "Cannot bind socket" << s << ":" << socket->errorString();
+            delete socket;
+            close();
+            return false;
+        }
+#ifdef Q_OS_LINUX
+        //unconnected sockets report ICMP errors only through the error queue
+        const int on = 1;
+        setsockopt(static_cast<int>(socket->socketDescriptor()), SOL_IP, IP_RECVERR,
+                   &on, sizeof(on));
+        setsockopt(static_cast<int>(socket->socketDescriptor()), SOL_IPV6, IPV6_RECVERR,
+                   &on, sizeof(on));
+#endif
+        _sockets.append(socket);
+    }
+    _clock.start();
+    _next = 0;
+    return !_sockets.isEmpty();
+}
+
+void UdpTransport::close()
+{
+    qDeleteAll(_sockets);
+    _sockets.clear();
+}
+
+quint16 UdpTransport::localPort(int s) const
+{
+    return _sockets.at(s)->localPort();
+}
+
+QString UdpTransport::errorString(int s) const
+{
+    return _sockets.at(s)->errorString();
+}
+
+bool UdpTransport::send(int s, const QByteArray &data, const QHostAddress &host,
+                        quint16 port)
+{
+    QUdpSocket *socket = _sockets.at(s);
+    if (socket->writeDatagram(data, host, port) == data.length()) {
+        return true;
+    }
+#ifdef Q_OS_LINUX
+    //with IP_RECVERR an ICMP error received for any transfer on this socket
+    //also fails its next send once, whatever the destination
+    return socket->writeDatagram(data, host, port) == data.length();
+#else
+    return false;
+#endif
+}
+
+bool UdpTransport::receive(int s, Datagram *datagram)
+{
+    QUdpSocket *socket = _sockets.at(s);
+    if (!socket->hasPendingDatagrams()) {
+        return receiveError(socket->socketDescriptor(), datagram);
+    }
+    const qint64 size = socket->pendingDatagramSize();
+    if (0 > size) {
+        return false;
+    }
+    datagram->data.resize(static_cast<int>(size));
+    const qint64 len = socket->readDatagram(datagram->data.data(), datagram->data.size(),
+                                            &datagram->sender, &datagram->senderPort);
+    if (0 > len) {
+        return false;
+    }
+    datagram->data.resize(static_cast<int>(len));
+    datagram->unreachable = false;
+    return true;
+}
+
+bool UdpTransport::receiveError(qintptr descriptor, Datagram *datagram)
+{
+#ifdef Q_OS_LINUX
+    //the name of the message is the destination of the datagram that bounced
+    sockaddr_storage name;
+    char control[512];
+    iovec iov = {nullptr, 0};
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &name;
+    msg.msg_namelen = sizeof(name);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (0 > recvmsg(static_cast<int>(descriptor), &msg, MSG_ERRQUEUE | MSG_DONTWAIT)) {
+        return false;
+    }
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); nullptr != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        const bool isIPv4 = (SOL_IP == cmsg->cmsg_level) && (IP_RECVERR == cmsg->cmsg_type);
+        const bool isIPv6 = (SOL_IPV6 == cmsg->cmsg_level) && (IPV6_RECVERR == cmsg->cmsg_type);
+        if (!isIPv4 && !isIPv6) {
+            continue;
+        }
+        const sock_extended_err *err = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+        if ((SO_EE_ORIGIN_ICMP != err->ee_origin) && (SO_EE_ORIGIN_ICMP6 != err->ee_origin)) {
+            continue;
+        }
+        if (!isUnreachable(err)) {
+            //e.g. time exceeded or fragmentation needed, the host may be alive
+            break;
+        }
+        datagram->data.clear();
+        datagram->sender.setAddress(reinterpret_cast<const sockaddr*>(&name));
+        datagram->senderPort = (AF_INET6 == name.ss_family) ?
+                    ntohs(reinterpret_cast<const sockaddr_in6*>(&name)->sin6_port) :
+                    ntohs(reinterpret_cast<const sockaddr_in*>(&name)->sin_port);
+        datagram->unreachable = true;
+        return true;
+    }
+    //not an unreachable error, look for the next one
+    return receiveError(descriptor, datagram);
+#else
+    //ICMP errors of unconnected sockets are not reported, transfers time out
+    Q_UNUSED(descriptor)
+    Q_UNUSED(datagram)
+    return false;
+#endif
+}
+
+void UdpTransport::wait(int timeoutMs)
+{
+    if (_sockets.isEmpty()) {
+        return;
+    }
+    //QUdpSocket can only block on one socket, so take them in turn
+    _sockets.at(_next)->waitForReadyRead(timeoutMs);
+    _next = (_next + 1) % _sockets.size();
+}
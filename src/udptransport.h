@@ -0,0 +1,30 @@
+#pragma once
+
+#include "transport.h"
+#include <QUdpSocket>
+#include <QElapsedTimer>
+#include <QVector>
+
+//transport backed by QUdpSocket, the default on all platforms
+class UdpTransport : public Transport
+{
+public:
+    ~UdpTransport() override;
+    bool open(int numSockets) override;
+    void close() override;
+    int socketCount() const override { return _sockets.size(); }
+    quint16 localPort(int s) const override;
+    QString errorString(int s) const override;
+    bool send(int s, const QByteArray &data, const QHostAddress &host,
+              quint16 port) override;
+    bool receive(int s, Datagram *datagram) override;
+    void wait(int timeoutMs) override;
+    qint64 now() const override { return _clock.elapsed(); }
+    //reads the next ICMP error from the error queue of the socket
+    static bool receiveError(qintptr descriptor, Datagram *datagram);
+private:
+
+    QVector<QUdpSocket*> _sockets;
+    QElapsedTimer _clock;
+    int _next = 0;
+};
@@ -0,0 +1,80 @@
+#include <QtTest>
+#include <QHostAddress>
+#include "addressshard.h"
+
+class TestAddressShard : public QObject
+{
+    Q_OBJECT
+private:
+    typedef QVector<QPair<quint32, quint32> > Ranges;
+    static QStringList expand(const QVector<QString> &singleAddresses, const Ranges &pairAddresses);
+private slots:
+    void coversEveryAddressOnce();
+    void splitsFullRange();
+};
+
+QStringList TestAddressShard::expand(const QVector<QString> &singleAddresses,
+                                     const Ranges &pairAddresses)
+{
+    QStringList out;
+    for (const auto &ip: singleAddresses) {
+        out.append(ip);
+    }
+    for (const auto &pairIp: pairAddresses) {
+        for (quint64 ipNum = pairIp.first; ipNum <= pairIp.second; ++ipNum) {
+            out.append(QHostAddress(static_cast<quint32>(ipNum)).toString());
+        }
+    }
+    return out;
+}
+
+void TestAddressShard::coversEveryAddressOnce()
+{
+    QVector<QString> singleAddresses;
+    singleAddresses << "10.0.0.1" << "10.0.0.9" << "10.0.0.5";
+    Ranges pairAddresses;
+    pairAddresses << qMakePair(QHostAddress("10.1.0.0").toIPv4Address(),
+                               QHostAddress("10.1.0.9").toIPv4Address());
+    pairAddresses << qMakePair(QHostAddress("10.2.0.5").toIPv4Address(),
+                               QHostAddress("10.2.0.5").toIPv4Address());
+    //crosses an octet boundary
+    pairAddresses << qMakePair(QHostAddress("10.3.0.250").toIPv4Address(),
+                               QHostAddress("10.3.1.3").toIPv4Address());
+    const QStringList all = expand(singleAddresses, pairAddresses);
+    QCOMPARE(all.size(), 24);
+
+    //more shards than addresses leaves some of them empty
+    for (int count = 1; count <= 30; ++count) {
+        QStringList swept;
+        for (int index = 0; index < count; ++index) {
+            QVector<QString> singles = singleAddresses;
+            Ranges pairs = pairAddresses;
+            const quint64 size = AddressShard::apply(index, count, &singles, &pairs);
+            const QStringList slice = expand(singles, pairs);
+            QCOMPARE(static_cast<quint64>(slice.size()), size);
+            //the slices differ by one address at most
+            QVERIFY(size * count <= static_cast<quint64>(all.size() + count));
+            swept.append(slice);
+        }
+        QCOMPARE(swept, all);
+    }
+}
+
+void TestAddressShard::splitsFullRange()
+{
+    const Ranges all = Ranges() << qMakePair(quint32(0), quint32(0xffffffff));
+    quint64 next = 0;
+    for (int index = 0; index < 3; ++index) {
+        QVector<QString> singles;
+        Ranges pairs = all;
+        const quint64 size = AddressShard::apply(index, 3, &singles, &pairs);
+        QCOMPARE(pairs.size(), 1);
+        QCOMPARE(static_cast<quint64>(pairs.at(0).first), next);
+        QCOMPARE(static_cast<quint64>(pairs.at(0).second) - pairs.at(0).first + 1, size);
+        next += size;
+    }
+    QCOMPARE(next, Q_UINT64_C(0x100000000));
+}
+
+QTEST_GUILESS_MAIN(TestAddressShard)
+#include "tst_addressshard.moc"
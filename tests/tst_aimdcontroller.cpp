@@ -0,0 +1,71 @@
+#include <QtTest>
+#include "aimdcontroller.h"
+
+class TestAimdController : public QObject
+{
+    Q_OBJECT
+private slots:
+    void growsWhenHealthy();
+    void mixedHostRtts();
+    void halvesOnStalls();
+    void halvesOnQueueing();
+};
+
+void TestAimdController::growsWhenHealthy()
+{
+    AimdController aimd;
+    aimd.reset(1, 4, 0);
+    for (int n = 1; n <= 10; ++n) {
+        aimd.onFinished(false, false);
+        aimd.update(n * AimdController::INTERVAL_MS);
+    }
+    //one more transfer per interval up to the limit
+    QCOMPARE(aimd.window(), 4);
+}
+
+void TestAimdController::mixedHostRtts()
+{
+    AimdController aimd;
+    aimd.reset(1, 8, 0);
+    for (int n = 1; n <= 10; ++n) {
+        //a LAN host next to a distant one is no sign of queueing
+        for (int sample = 0; sample < 10; ++sample) {
+            aimd.onRtt(1, 1);
+            aimd.onRtt(2, 20);
+        }
+        aimd.onFinished(false, false);
+        aimd.update(n * AimdController::INTERVAL_MS);
+    }
+    QCOMPARE(aimd.window(), 8);
+}
+
+void TestAimdController::halvesOnStalls()
+{
+    AimdController aimd;
+    aimd.reset(8, 8, 0);
+    aimd.onFinished(true, true);
+    QVERIFY(aimd.update(AimdController::INTERVAL_MS));
+    QCOMPARE(aimd.window(), 4);
+    //held for one interval, then grows again
+    QVERIFY(!aimd.update(2 * AimdController::INTERVAL_MS));
+    QCOMPARE(aimd.window(), 4);
+    QVERIFY(aimd.update(3 * AimdController::INTERVAL_MS));
+    QCOMPARE(aimd.window(), 5);
+}
+
+void TestAimdController::halvesOnQueueing()
+{
+    AimdController aimd;
+    aimd.reset(4, 8, 0);
+    for (int sample = 0; sample < 5; ++sample) {
+        aimd.onRtt(1, 10);
+    }
+    for (int sample = 0; sample < 20; ++sample) {
+        aimd.onRtt(1, 40);
+    }
+    QVERIFY(aimd.update(AimdController::INTERVAL_MS));
+    QCOMPARE(aimd.window(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestAimdController)
+#include "tst_aimdcontroller.moc"
@@ -0,0 +1,378 @@
+#include <QtTest>
+#include "dispatcher.h"
+#include "requestplan.h"
+#include "simtransport.h"
+#include <chrono>
+
+//drives the dispatcher step by step over the simulated network, the tests
+//only take as long as the CPU work since the clock is virtual
+class TestDispatcher : public QObject
+{
+    Q_OBJECT
+private:
+    enum { READ_DELAY_MS = 1000, MAX_STEPS = 100000 };
+    static QByteArray makeFile(int size, char first);
+    static bool isReady(const std::future<Dispatcher::Result> &future);
+    static Dispatcher::Result run(Dispatcher *dispatcher, std::future<Dispatcher::Result> *future);
+private slots:
+    void download();
+    void fileNotFound();
+    void rrqTimeout();
+    void lostAck();
+    void portClosed();
+    void unreachableHostFailsQueued();
+    void cancel();
+    void twoHosts();
+    void lateDataIsNotAdopted();
+    void netascii();
+    void replyFromListenPort();
+    void lateFirstReplyIsNotAdopted();
+};
+
+QByteArray TestDispatcher::makeFile(int size, char first)
+{
+    QByteArray file;
+    for (int n = 0; n < size; ++n) {
+        file.append(static_cast<char>(first + n % 26));
+    }
+    return file;
+}
+
+bool TestDispatcher::isReady(const std::future<Dispatcher::Result> &future)
+{
+    return std::future_status::ready == future.wait_for(std::chrono::seconds(0));
+}
+
+Dispatcher::Result TestDispatcher::run(Dispatcher *dispatcher,
+                                       std::future<Dispatcher::Result> *future)
+{
+    for (int n = 0; (n < MAX_STEPS) && !isReady(*future); ++n) {
+        dispatcher->step();
+    }
+    if (!isReady(*future)) {
+        Dispatcher::Result result;
+        result.error = "Transfer did not complete";
+        return result;
+    }
+    return future->get();
+}
+
+void TestDispatcher::download()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.latencyMs = 3;
+    //exactly two full blocks, the transfer ends with an empty DATA
+    script.files.insert("a.cfg", makeFile(1024, 'a'));
+    script.files.insert("b.cfg", makeFile(1300, 'b'));
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(2);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto first = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    auto second = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("b.cfg"));
+    const Dispatcher::Result a = run(&dispatcher, &first);
+    const Dispatcher::Result b = run(&dispatcher, &second);
+    dispatcher.close();
+
+    QCOMPARE(a.status, Dispatcher::Success);
+    QCOMPARE(a.content, script.files.value("a.cfg"));
+    QCOMPARE(b.status, Dispatcher::Success);
+    QCOMPARE(b.content, script.files.value("b.cfg"));
+}
+
+void TestDispatcher::fileNotFound()
+{
+    SimTransport *sim = new SimTransport();
+    sim->addHost("10.0.0.1", SimTransport::HostScript());
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto future = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("missing.cfg"));
+    const Dispatcher::Result result = run(&dispatcher, &future);
+    dispatcher.close();
+
+    QCOMPARE(result.status, Dispatcher::Error);
+    QCOMPARE(result.errorCode, 1);
+}
+
+void TestDispatcher::rrqTimeout()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.files.insert("a.cfg", makeFile(100, 'a'));
+    //the RRQ is the first datagram exchanged with the host
+    script.dropped.insert(0);
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto future = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result result = run(&dispatcher, &future);
+    const qint64 elapsed = sim->now();
+    dispatcher.close();
+
+    QCOMPARE(result.status, Dispatcher::Timeout);
+    QVERIFY(READ_DELAY_MS <= elapsed);
+    QVERIFY(READ_DELAY_MS + 2 * static_cast<int>(Dispatcher::POLL_INTERVAL_MS) >= elapsed);
+}
+
+void TestDispatcher::lostAck()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.retransmitMs = 100;
+    script.files.insert("a.cfg", makeFile(1200, 'a'));
+    //RRQ, DATA 1, then the ACK of block 1 is lost and DATA 1 comes again
+    script.dropped.insert(2);
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto future = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result result = run(&dispatcher, &future);
+    const qint64 elapsed = sim->now();
+    dispatcher.close();
+
+    QCOMPARE(result.status, Dispatcher::Success);
+    QCOMPARE(result.content, script.files.value("a.cfg"));
+    //recovered by the retransmission of the server, not by a timeout
+    QVERIFY(READ_DELAY_MS > elapsed);
+}
+
+void TestDispatcher::portClosed()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.portClosed = true;
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto future = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result result = run(&dispatcher, &future);
+    const qint64 elapsed = sim->now();
+    dispatcher.close();
+
+    QCOMPARE(result.status, Dispatcher::Unreachable);
+    QVERIFY(READ_DELAY_MS > elapsed);
+}
+
+void TestDispatcher::unreachableHostFailsQueued()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript closed;
+    closed.latencyMs = 10;
+    closed.portClosed = true;
+    sim->addHost("10.0.0.1", closed);
+    SimTransport::HostScript open;
+    open.files.insert("a.cfg", makeFile(100, 'a'));
+    sim->addHost("10.0.0.2", open);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    //only the first request is sent, the other ones wait for the socket
+    auto first = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    auto queued = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("b.cfg"));
+    auto other = dispatcher.submit("10.0.0.2", RequestPlan::rrqPacket("a.cfg"));
+    QCOMPARE(run(&dispatcher, &first).status, Dispatcher::Unreachable);
+    QVERIFY(isReady(queued));
+    QCOMPARE(queued.get().status, Dispatcher::Unreachable);
+    auto late = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("c.cfg"));
+    QVERIFY(isReady(late));
+    QCOMPARE(late.get().status, Dispatcher::Unreachable);
+    //other hosts are not affected
+    QCOMPARE(run(&dispatcher, &other).status, Dispatcher::Success);
+    dispatcher.close();
+}
+
+void TestDispatcher::cancel()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.files.insert("a.cfg", makeFile(100, 'a'));
+    script.dropped.insert(0);
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    //the second transfer waits for the first one to bind its TID
+    auto pending = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    auto waiting = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    for (int n = 0; n < 10; ++n) {
+        dispatcher.step();
+    }
+    QVERIFY(!isReady(pending));
+    QVERIFY(!isReady(waiting));
+    dispatcher.cancel();
+    dispatcher.step();
+    QVERIFY(isReady(pending));
+    QVERIFY(isReady(waiting));
+    QCOMPARE(pending.get().status, Dispatcher::Cancelled);
+    QCOMPARE(waiting.get().status, Dispatcher::Cancelled);
+
+    auto late = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    QVERIFY(isReady(late));
+    QCOMPARE(late.get().status, Dispatcher::Cancelled);
+    dispatcher.close();
+}
+
+void TestDispatcher::twoHosts()
+{
+    SimTransport *sim = new SimTransport(7);
+    SimTransport::HostScript near;
+    near.latencyMs = 1;
+    near.files.insert("a.cfg", makeFile(3000, 'n'));
+    sim->addHost("10.0.0.1", near);
+    SimTransport::HostScript far;
+    far.latencyMs = 20;
+    far.jitterMs = 5;
+    far.files.insert("a.cfg", makeFile(2000, 'f'));
+    sim->addHost("10.0.0.2", far);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    //both transfers share the only socket and run at the same time
+    auto fromFar = dispatcher.submit("10.0.0.2", RequestPlan::rrqPacket("a.cfg"));
+    auto fromNear = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result nearResult = run(&dispatcher, &fromNear);
+    QVERIFY(!isReady(fromFar));
+    const Dispatcher::Result farResult = run(&dispatcher, &fromFar);
+    dispatcher.close();
+
+    QCOMPARE(nearResult.status, Dispatcher::Success);
+    QCOMPARE(nearResult.content, near.files.value("a.cfg"));
+    QCOMPARE(farResult.status, Dispatcher::Success);
+    QCOMPARE(farResult.content, far.files.value("a.cfg"));
+}
+
+void TestDispatcher::lateDataIsNotAdopted()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.latencyMs = 100;
+    script.retransmitMs = 10;
+    script.files.insert("a.cfg", makeFile(100, 'a'));
+    script.files.insert("b.cfg", makeFile(100, 'b'));
+    //the server retransmits DATA 1 of a.cfg long before its ACK can come back
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto first = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result a = run(&dispatcher, &first);
+    //the retransmissions reach the socket while b.cfg waits for its first DATA
+    auto second = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("b.cfg"));
+    const Dispatcher::Result b = run(&dispatcher, &second);
+    dispatcher.close();
+
+    QCOMPARE(a.status, Dispatcher::Success);
+    QCOMPARE(b.status, Dispatcher::Success);
+    QCOMPARE(b.content, script.files.value("b.cfg"));
+}
+
+void TestDispatcher::netascii()
+{
+    //CR LF split by the first block boundary, CR NUL by the second one
+    QByteArray wire = makeFile(511, 'a');
+    QByteArray text = wire;
+    wire.append("\r\n");
+    text.append('\n');
+    const QByteArray middle = makeFile(510, 'b');
+    wire.append(middle);
+    text.append(middle);
+    wire.append('\r');
+    wire.append('\0');
+    text.append('\r');
+    //a bare CR is kept, as is a CR that ends the file
+    wire.append("x\ry\r");
+    text.append("x\ry\r");
+
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.files.insert("a.txt", wire);
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    dispatcher.setNetascii(true);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto future = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.txt", "netascii"));
+    const Dispatcher::Result result = run(&dispatcher, &future);
+    dispatcher.close();
+
+    QCOMPARE(result.status, Dispatcher::Success);
+    QCOMPARE(result.content, text);
+}
+
+void TestDispatcher::replyFromListenPort()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    script.replyFromListenPort = true;
+    script.files.insert("a.cfg", makeFile(700, 'a'));
+    script.files.insert("b.cfg", makeFile(700, 'b'));
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    //both transfers use the same local port and the same server port
+    auto first = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    auto second = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("b.cfg"));
+    const Dispatcher::Result a = run(&dispatcher, &first);
+    const Dispatcher::Result b = run(&dispatcher, &second);
+    dispatcher.close();
+
+    QCOMPARE(a.status, Dispatcher::Success);
+    QCOMPARE(a.content, script.files.value("a.cfg"));
+    QCOMPARE(b.status, Dispatcher::Success);
+    QCOMPARE(b.content, script.files.value("b.cfg"));
+}
+
+void TestDispatcher::lateFirstReplyIsNotAdopted()
+{
+    SimTransport *sim = new SimTransport();
+    SimTransport::HostScript script;
+    //the round trip is longer than the read delay
+    script.latencyMs = READ_DELAY_MS * 6 / 10;
+    script.files.insert("a.cfg", makeFile(100, 'a'));
+    script.files.insert("b.cfg", makeFile(100, 'b'));
+    script.files.insert("c.cfg", makeFile(100, 'c'));
+    sim->addHost("10.0.0.1", script);
+    Dispatcher dispatcher(1);
+    dispatcher.setTransport(sim);
+    QVERIFY(dispatcher.open(69, READ_DELAY_MS));
+
+    auto first = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("a.cfg"));
+    const Dispatcher::Result a = run(&dispatcher, &first);
+    //the reply to a.cfg is still on its way, it must not be taken for b.cfg
+    auto second = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("b.cfg"));
+    const Dispatcher::Result b = run(&dispatcher, &second);
+    //once the late reply has come, the port is used again
+    while (2 * READ_DELAY_MS > sim->now()) {
+        dispatcher.step();
+    }
+    const qint64 sent = sim->now();
+    auto third = dispatcher.submit("10.0.0.1", RequestPlan::rrqPacket("c.cfg"));
+    const Dispatcher::Result c = run(&dispatcher, &third);
+    const qint64 elapsed = sim->now() - sent;
+    dispatcher.close();
+
+    QCOMPARE(a.status, Dispatcher::Timeout);
+    QCOMPARE(b.status, Dispatcher::Timeout);
+    QCOMPARE(c.status, Dispatcher::Timeout);
+    QVERIFY(READ_DELAY_MS <= elapsed);
+}
+
+QTEST_GUILESS_MAIN(TestDispatcher)
+#include "tst_dispatcher.moc"
@@ -0,0 +1,99 @@
+#include <QtTest>
+#include "netasciidecoder.h"
+#include <random>
+
+class TestNetasciiDecoder : public QObject
+{
+    Q_OBJECT
+private:
+    static QByteArray decodeSplit(const QByteArray &wire, int split);
+private slots:
+    void decode_data();
+    void decode();
+    void everySplit();
+    void matchesScalar();
+};
+
+QByteArray TestNetasciiDecoder::decodeSplit(const QByteArray &wire, int split)
+{
+    NetasciiDecoder decoder;
+    QByteArray text;
+    decoder.decode(wire.constData(), split, &text);
+    decoder.decode(wire.constData() + split, wire.size() - split, &text);
+    decoder.finish(&text);
+    return text;
+}
+
+void TestNetasciiDecoder::decode_data()
+{
+    QTest::addColumn<QByteArray>("wire");
+    QTest::addColumn<QByteArray>("text");
+
+    QTest::newRow("empty") << QByteArray() << QByteArray();
+    QTest::newRow("crlf") << QByteArray("a\r\nb\r\n") << QByteArray("a\nb\n");
+    QTest::newRow("crnul") << QByteArray("a\r\0b", 4) << QByteArray("a\rb");
+    QTest::newRow("bare cr") << QByteArray("a\rb") << QByteArray("a\rb");
+    QTest::newRow("trailing cr") << QByteArray("ab\r") << QByteArray("ab\r");
+    QTest::newRow("cr cr lf") << QByteArray("\r\r\n") << QByteArray("\r\n");
+    //past the width of the vector search
+    QTest::newRow("long line") << QByteArray(100, 'x') + "\r\n" << QByteArray(100, 'x') + "\n";
+}
+
+void TestNetasciiDecoder::decode()
+{
+    QFETCH(QByteArray, wire);
+    QFETCH(QByteArray, text);
+
+    NetasciiDecoder decoder;
+    QByteArray out;
+    decoder.decode(wire.constData(), wire.size(), &out);
+    decoder.finish(&out);
+    QCOMPARE(out, text);
+}
+
+void TestNetasciiDecoder::everySplit()
+{
+    //a block may end between the CR and its LF or NUL
+    QByteArray wire(40, 'a');
+    wire.append("\r\n");
+    wire.append(QByteArray(30, 'b'));
+    wire.append('\r');
+    wire.append('\0');
+    wire.append("c\rd\r");
+    QByteArray text(40, 'a');
+    text.append('\n');
+    text.append(QByteArray(30, 'b'));
+    text.append("\rc\rd\r");
+    for (int split = 0; split <= wire.size(); ++split) {
+        QCOMPARE(decodeSplit(wire, split), text);
+    }
+}
+
+void TestNetasciiDecoder::matchesScalar()
+{
+    std::mt19937 rng(1);
+    const char alphabet[] = {'\r', '\n', '\0', 'a', ' '};
+    for (int round = 0; round < 1000; ++round) {
+        QByteArray wire;
+        const int size = static_cast<int>(rng() % 600);
+        for (int i = 0; i < size; ++i) {
+            wire.append(alphabet[rng() % sizeof(alphabet)]);
+        }
+        //TFTP sized blocks, the last one is shorter
+        NetasciiDecoder vectorized;
+        NetasciiDecoder scalar;
+        QByteArray fast;
+        QByteArray slow;
+        for (int offset = 0; offset < wire.size(); offset += 512) {
+            const int len = qMin(512, wire.size() - offset);
+            vectorized.decode(wire.constData() + offset, len, &fast);
+            scalar.decodeScalar(wire.constData() + offset, len, &slow);
+        }
+        vectorized.finish(&fast);
+        scalar.finish(&slow);
+        QCOMPARE(fast, slow);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestNetasciiDecoder)
+#include "tst_netasciidecoder.moc"
@@ -0,0 +1,63 @@
+#include <QtTest>
+#include "requestplan.h"
+
+class TestRequestPlan : public QObject
+{
+    Q_OBJECT
+private slots:
+    void expand_data();
+    void expand();
+    void render();
+};
+
+void TestRequestPlan::expand_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<quint32>("address");
+    QTest::addColumn<QString>("filename");
+
+    QTest::newRow("static") << "router.cfg" << 0x0A000001u << "router.cfg";
+    QTest::newRow("ip") << "{ip}.cfg" << 0xC0A80001u << "192.168.0.1.cfg";
+    QTest::newRow("ip_hex") << "{ip_hex}" << 0xC0A8FE0Au << "C0A8FE0A";
+    //always eight digits
+    QTest::newRow("ip_hex padded") << "{ip_hex}" << 0x0A000001u << "0A000001";
+    QTest::newRow("last_octet") << "sw-{last_octet}.cfg" << 0x0A010200u << "sw-0.cfg";
+    QTest::newRow("several") << "{last_octet}/{ip_hex}-{ip}" << 0x0A0000FFu
+                             << "255/0A0000FF-10.0.0.255";
+    QTest::newRow("unknown") << "{mac}-{ip}.cfg" << 0x0A000001u << "{mac}-10.0.0.1.cfg";
+    QTest::newRow("unclosed") << "cfg-{ip" << 0x0A000001u << "cfg-{ip";
+    QTest::newRow("nested") << "{x{ip}}" << 0x0A000001u << "{x10.0.0.1}";
+}
+
+void TestRequestPlan::expand()
+{
+    QFETCH(QString, pattern);
+    QFETCH(quint32, address);
+    QFETCH(QString, filename);
+
+    QCOMPARE(RequestPlan::expand(pattern, address), filename);
+}
+
+void TestRequestPlan::render()
+{
+    RequestPlan plan;
+    plan.setMode("netascii");
+    QString error;
+    //not an existing file, taken as the name to download
+    QVERIFY(plan.compile("cfg/", "{last_octet}-switch", "txt", &error));
+    QCOMPARE(plan.size(), 1);
+    QCOMPARE(plan.patterns(), QStringList() << "cfg/{last_octet}-switch.txt");
+
+    //the buffers are reused from one host to the next
+    QString filename;
+    QByteArray packet;
+    plan.render(0, 0x0A000010u, &filename, &packet);
+    QCOMPARE(filename, QString("cfg/16-switch.txt"));
+    QCOMPARE(packet, RequestPlan::rrqPacket(filename, "netascii"));
+    plan.render(0, 0x0A000002u, &filename, &packet);
+    QCOMPARE(filename, QString("cfg/2-switch.txt"));
+    QCOMPARE(packet, RequestPlan::rrqPacket(filename, "netascii"));
+}
+
+QTEST_GUILESS_MAIN(TestRequestPlan)
+#include "tst_requestplan.moc"